@@ -82,6 +82,10 @@ int main( void ) {
         INIWriter writer("../API/AudioDAQ_" + to_string(i + 1) + ".ini");
         writer.setValue("AudioDAQ", "device", to_string(choice[i]));
         writer.setValue("AudioDAQ", "sampleRate", to_string(sampleRate));
+        writer.setValue("AudioDAQ", "channels", "1");
+        writer.setValue("AudioDAQ", "format", "S16_LE");
+        writer.setValue("AudioDAQ", "sampleType", "raw");
+        writer.setValue("AudioDAQ", "access", "rw"); // "mmap" is opt-in; period and buffer sizes stay the driver's
         writer.save();
     }
 
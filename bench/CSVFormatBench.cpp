@@ -0,0 +1,74 @@
+// CSVFormatBench.cpp
+// Measures CSV row formatting throughput: the stream-based writer (operator<< on
+// an ofstream) against CSVFormatter with shortest round-trip and fixed precision.
+#include "../include/CSVFormatter.h"
+#include "../include/BufferedFile.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+
+using namespace std;
+
+static const char* SINK = "/dev/null";
+
+static void report(const char* name, size_t rows, double seconds) {
+    cout << name << ": " << rows / seconds / 1e6 << " M rows/s ("
+         << seconds * 1e9 / rows << " ns/row)" << endl;
+}
+
+// The original CSVWriter loop.
+static double runStream(const vector<double>& block, int numChannels, int repeats) {
+    ofstream file(SINK, ios::app);
+    auto start = chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r) {
+        for (size_t i = 0; i < block.size(); i += numChannels) {
+            for (int j = 0; j < numChannels; ++j) {
+                file << block[i + j];
+                if (j < numChannels - 1) {
+                    file << ",";
+                }
+            }
+            file << "\n";
+        }
+    }
+    file.flush();
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static double runFormatter(const vector<double>& block, int numChannels, int repeats, int precision) {
+    BufferedFile file;
+    file.open(SINK);
+    CSVFormatter formatter(numChannels);
+    formatter.setPrecision(precision);
+    auto start = chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r) {
+        for (size_t i = 0; i < block.size(); i += numChannels) {
+            size_t length = formatter.formatRow(&block[i]);
+            file.sputn(formatter.data(), length);
+        }
+    }
+    file.flush();
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    int numChannels = argc > 1 ? stoi(argv[1]) : 3;
+    int sampleRate = argc > 2 ? stoi(argv[2]) : 12800;
+    int repeats = argc > 3 ? stoi(argv[3]) : 20;
+
+    // Scaled accelerometer values in g, as produced by DAQmxReadAnalogF64.
+    vector<double> block(static_cast<size_t>(sampleRate) * numChannels);
+    for (size_t i = 0; i < block.size(); ++i) {
+        block[i] = 0.25 * sin(i * 0.001) + 1e-4 * (i % 97);
+    }
+    size_t rows = static_cast<size_t>(sampleRate) * repeats;
+
+    cout << "CSV format benchmark: " << numChannels << " channels, " << rows << " rows" << endl;
+    report("ofstream operator<<", rows, runStream(block, numChannels, repeats));
+    report("to_chars shortest", rows, runFormatter(block, numChannels, repeats, CSVFormatter::SHORTEST));
+    report("to_chars fixed 6", rows, runFormatter(block, numChannels, repeats, 6));
+    return 0;
+}
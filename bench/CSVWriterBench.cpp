@@ -0,0 +1,85 @@
+// CSVWriterBench.cpp
+// Compares the per-block open/append/close path of CSVWriter with the persistent
+// buffered mode. Reports sustained MB/s and write syscalls per block.
+#include "../include/CSVWriter.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+
+using namespace std;
+namespace fs = filesystem;
+
+// Read the number of write syscalls issued by this process from /proc/self/io.
+static long long writeSyscalls() {
+    ifstream io("/proc/self/io");
+    string key;
+    long long value;
+    while (io >> key >> value) {
+        if (key == "syscw:") {
+            return value;
+        }
+    }
+    return -1;
+}
+
+// Total size of all files written into a directory.
+static uintmax_t directoryBytes(const string& dir) {
+    uintmax_t total = 0;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        total += entry.file_size();
+    }
+    return total;
+}
+
+static void runMode(const char* name, CSVWriter::Mode mode, int numChannels, int sampleRate, int blocks, int saveUnit) {
+    string dir = "bench_output/" + string(name);
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+
+    // One block of synthetic accelerometer-like data, as delivered by the NiDAQ read loop.
+    vector<double> block(static_cast<size_t>(sampleRate) * numChannels);
+    for (size_t i = 0; i < block.size(); ++i) {
+        block[i] = 0.25 * sin(i * 0.001) + 1e-4 * (i % 97);
+    }
+
+    long long syscallsBefore = writeSyscalls();
+    auto start = chrono::steady_clock::now();
+    {
+        CSVWriter writer(numChannels, dir, "bench", mode);
+        for (int b = 0; b < blocks; ++b) {
+            vector<double> copy(block);
+            writer.addDataBlock(move(copy));
+            if ((b + 1) % saveUnit == 0) {
+                writer.updateFilename();
+            }
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    long long syscalls = writeSyscalls() - syscallsBefore;
+
+    double megabytes = directoryBytes(dir) / 1e6;
+    double opensPerBlock = (mode == CSVWriter::Mode::Reopen) ? 1.0 : static_cast<double>(blocks / saveUnit + 1) / blocks;
+    cout << name << ": " << megabytes / seconds << " MB/s, "
+         << static_cast<double>(syscalls) / blocks << " write syscalls/block, "
+         << opensPerBlock << " open+close/block, "
+         << seconds * 1000.0 / blocks << " ms/block" << endl;
+    fs::remove_all(dir);
+}
+
+int main(int argc, char** argv) {
+    int numChannels = argc > 1 ? stoi(argv[1]) : 3;
+    int sampleRate = argc > 2 ? stoi(argv[2]) : 12800;
+    int blocks = argc > 3 ? stoi(argv[3]) : 120;
+    int saveUnit = 60;
+
+    cout << "CSVWriter benchmark: " << numChannels << " channels, " << sampleRate
+         << " S/s, " << blocks << " blocks, SaveUnit " << saveUnit << endl;
+    runMode("reopen", CSVWriter::Mode::Reopen, numChannels, sampleRate, blocks, saveUnit);
+    runMode("persistent", CSVWriter::Mode::Persistent, numChannels, sampleRate, blocks, saveUnit);
+    return 0;
+}
@@ -0,0 +1,304 @@
+// CodecBench.cpp
+// Compression ratio and single-core encode/decode throughput of RiceCodec on
+// synthetic signals shaped like our recordings: raw NI codes of a vibration
+// sensor, 16- and 24-bit audio, and full-scale white noise as the worst case.
+// Every block is decoded again and compared, so a lossy bug fails the run. So does
+// 24-bit audio written as int32 whose stored codes differ from the captured ones.
+// It then writes compressed binary files through ParallelEncoder with 1, 2, 4, ...
+// pool threads to show how the compression stage scales with cores.
+//
+// Usage: codec_bench [--seconds 1] [--threads 1,2,4,8] [--json bench_output/codec_bench.json]
+#include "../include/RiceCodec.h"
+#include "../include/BinaryWriter.h"
+#include "../include/ParallelEncoder.h"
+#include "../include/CompressionPool.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <algorithm>
+#include <filesystem>
+#include <thread>
+#include <sstream>
+#include <cstring>
+
+using namespace std;
+namespace fs = filesystem;
+
+// One synthetic signal: `channels` channel-major columns of one second each.
+struct Signal {
+    string name;
+    int channels;
+    int rate;
+    int bits;                     // 16 or 32 (24-bit data is stored in 32)
+    vector<int32_t> samples;      // Channel-major, channels * rate samples
+};
+
+// One row of results.
+struct Result {
+    string name;
+    int bits;
+    double ratio;
+    double encodeMBps;
+    double decodeMBps;
+    bool lossless;
+};
+
+// Sine of `amplitude` at `frequency` plus gaussian noise, clamped to `bits`.
+static Signal makeSignal(const string& name, int channels, int rate, int bits, int storageBits,
+                         double amplitude, double frequency, double noise, mt19937& random) {
+    Signal signal = { name, channels, rate, storageBits, {} };
+    normal_distribution<double> gaussian(0.0, noise);
+    const double high = ldexp(1.0, bits - 1) - 1;
+    signal.samples.resize(static_cast<size_t>(channels) * rate);
+    for (int c = 0; c < channels; ++c) {
+        for (int i = 0; i < rate; ++i) {
+            double t = static_cast<double>(i) / rate;
+            double value = amplitude * sin(2 * M_PI * frequency * (c + 1) * t) +
+                           0.3 * amplitude * sin(2 * M_PI * frequency * 3.1 * t) + gaussian(random);
+            signal.samples[static_cast<size_t>(c) * rate + i] = static_cast<int32_t>(lround(max(-high - 1, min(high, value))));
+        }
+    }
+    return signal;
+}
+
+static Signal makeNoise(const string& name, int channels, int rate, mt19937& random) {
+    Signal signal = { name, channels, rate, 16, {} };
+    uniform_int_distribution<int> uniform(-32768, 32767);
+    signal.samples.resize(static_cast<size_t>(channels) * rate);
+    for (int32_t& sample : signal.samples) {
+        sample = uniform(random);
+    }
+    return signal;
+}
+
+// Encodes the signal's block over and over for at least `seconds`, then decodes it likewise.
+template <typename T>
+static Result run(const Signal& signal, double seconds) {
+    const size_t count = static_cast<size_t>(signal.rate);
+    vector<T> block(signal.samples.begin(), signal.samples.end());
+    vector<T> decoded(block.size());
+    vector<uint8_t> encoded;
+    const double rawBytes = static_cast<double>(block.size() * sizeof(T));
+
+    auto encodeBlock = [&]() {
+        encoded.clear();
+        for (int c = 0; c < signal.channels; ++c) {
+            RiceCodec::encode(block.data() + c * count, count, encoded);
+        }
+    };
+
+    size_t rounds = 0;
+    auto start = chrono::steady_clock::now();
+    double elapsed = 0;
+    do {
+        encodeBlock();
+        ++rounds;
+        elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    } while (elapsed < seconds);
+    double encodeMBps = rawBytes * rounds / elapsed / 1e6;
+
+    bool lossless = true;
+    rounds = 0;
+    start = chrono::steady_clock::now();
+    do {
+        size_t offset = 0;
+        for (int c = 0; c < signal.channels && lossless; ++c) {
+            size_t used = RiceCodec::decode(encoded.data() + offset, encoded.size() - offset, decoded.data() + c * count, count);
+            lossless = used > 0;
+            offset += used;
+        }
+        ++rounds;
+        elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    } while (elapsed < seconds && lossless);
+    double decodeMBps = rawBytes * rounds / elapsed / 1e6;
+    lossless = lossless && decoded == block;
+
+    return { signal.name, signal.bits, rawBytes / encoded.size(), encodeMBps, decodeMBps, lossless };
+}
+
+// Writes interleaved S24 audio counts through BinaryWriter as Rice compressed int32 and
+// reads the file back: the codes must be stored unchanged, not rescaled to the full range.
+static bool checkPassThrough(mt19937& random) {
+    const int channels = 2;
+    const int samplesPerChannel = 4800;
+    vector<ChannelInfo> info(channels, { "ch", "counts", -8388608.0, 8388607.0 });
+    uniform_int_distribution<int32_t> uniform(-8388608, 8388607);
+    vector<int32_t> codes(static_cast<size_t>(channels) * samplesPerChannel);
+    for (int32_t& code : codes) {
+        code = uniform(random);
+    }
+
+    string dir = "bench_output/codec_passthrough";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    {
+        BinaryWriter writer(info, 48000.0, dir, "s24", BinaryWriter::SampleType::Int32);
+        writer.setCompression(BinaryWriter::Compression::Rice);
+        DataBlock block;
+        block.format = SampleFormat::Int32;
+        block.wideCodes = codes;
+        writer.addDataBlock(move(block));
+    }
+    string path;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        path = entry.path().string();
+    }
+    ifstream file(path, ios::binary);
+    vector<uint8_t> bytes((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    fs::remove_all(dir);
+
+    // Skip the file header and the "BLKR" header with its payload size
+    uint32_t headerSize = 0;
+    const size_t blockHeader = 36;
+    if (bytes.size() < 12) {
+        return false;
+    }
+    memcpy(&headerSize, bytes.data() + 8, sizeof(headerSize));
+    if (bytes.size() < headerSize + blockHeader || memcmp(bytes.data() + headerSize, "BLKR", 4) != 0) {
+        return false;
+    }
+    size_t offset = headerSize + blockHeader;
+    vector<int32_t> column(samplesPerChannel);
+    for (int c = 0; c < channels; ++c) {
+        size_t used = RiceCodec::decode(bytes.data() + offset, bytes.size() - offset, column.data(), column.size());
+        if (used == 0) {
+            return false;
+        }
+        offset += used;
+        for (int i = 0; i < samplesPerChannel; ++i) {
+            if (column[i] != codes[static_cast<size_t>(i) * channels + c]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// One row of the scaling measurement.
+struct ScalingResult {
+    size_t threads;
+    double MBps;
+};
+
+// 16 channels of raw 24-bit codes at 51.2 kHz, the widest NI configuration we record,
+// written as compressed int32 binary files through the compression stage.
+static ScalingResult runParallel(size_t threads, double seconds, mt19937& random) {
+    const int channels = 16;
+    const int samplesPerChannel = 5120; // 100 ms blocks
+    vector<ChannelInfo> info(channels, { "ch", "g", -5.0, 5.0, { 0.0, 5.0 / 8388608 } });
+    normal_distribution<double> noise(0.0, 60.0);
+    vector<int32_t> codes(static_cast<size_t>(channels) * samplesPerChannel);
+    for (size_t i = 0; i < codes.size(); ++i) {
+        codes[i] = static_cast<int32_t>(200000 * sin(i / channels * 0.01) + noise(random));
+    }
+    const double blockBytes = static_cast<double>(codes.size() * sizeof(int32_t));
+
+    string dir = "bench_output/codec_parallel";
+    fs::create_directories(dir);
+    size_t blocks = 0;
+    double elapsed = 0;
+    {
+        CompressionPool pool(threads, 64 * 1024 * 1024);
+        auto binary = make_unique<BinaryWriter>(info, 51200.0, dir, "bench", BinaryWriter::SampleType::Int32);
+        binary->setCompression(BinaryWriter::Compression::Rice);
+        ParallelEncoder encoder(move(binary), pool);
+        auto start = chrono::steady_clock::now();
+        do {
+            DataBlock block;
+            block.format = SampleFormat::Int32;
+            block.wideCodes = codes;
+            block.sequence = blocks++;
+            encoder.addDataBlock(move(block));
+            elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        } while (elapsed < seconds);
+        encoder.updateFilename(); // Waits for every block to be written
+        elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+    fs::remove_all(dir);
+    return { threads, blockBytes * blocks / elapsed / 1e6 };
+}
+
+static void writeJson(const string& path, const vector<Result>& results, const vector<ScalingResult>& scaling) {
+    fs::path parent = fs::path(path).parent_path();
+    if (!parent.empty()) {
+        fs::create_directories(parent);
+    }
+    ofstream json(path);
+    json << "{\n  \"benchmark\": \"codec\",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        json << "    {\"signal\": \"" << r.name << "\", \"bits\": " << r.bits << ", \"ratio\": " << r.ratio
+             << ", \"encode_MBps\": " << r.encodeMBps << ", \"decode_MBps\": " << r.decodeMBps
+             << ", \"lossless\": " << (r.lossless ? "true" : "false") << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    json << "  ],\n  \"parallel\": [\n";
+    for (size_t i = 0; i < scaling.size(); ++i) {
+        json << "    {\"threads\": " << scaling[i].threads << ", \"MBps\": " << scaling[i].MBps << "}"
+             << (i + 1 < scaling.size() ? "," : "") << "\n";
+    }
+    json << "  ]\n}\n";
+}
+
+int main(int argc, char** argv) {
+    double seconds = 1.0;
+    string jsonPath = "bench_output/codec_bench.json";
+    vector<size_t> threadCounts = { 1, 2, 4, 8 };
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string option = argv[i];
+        if (option == "--seconds") {
+            seconds = stod(argv[i + 1]);
+        } else if (option == "--json") {
+            jsonPath = argv[i + 1];
+        } else if (option == "--threads") {
+            threadCounts.clear();
+            stringstream list(argv[i + 1]);
+            string item;
+            while (getline(list, item, ',')) {
+                threadCounts.push_back(stoul(item));
+            }
+        }
+    }
+
+    mt19937 random(12345);
+    vector<Signal> signals;
+    signals.push_back(makeSignal("ni_int16_vibration", 4, 12800, 16, 16, 800, 37, 4, random));
+    signals.push_back(makeSignal("ni_int32_24bit", 4, 12800, 24, 32, 200000, 37, 60, random));
+    signals.push_back(makeSignal("audio_s16", 2, 44100, 16, 16, 8000, 440, 20, random));
+    signals.push_back(makeSignal("audio_s24", 2, 48000, 24, 32, 2000000, 440, 300, random));
+    signals.push_back(makeNoise("white_noise_s16", 2, 44100, random));
+
+    cout << "Codec benchmark: one core, one-second blocks, " << seconds << " s per measurement" << endl;
+    vector<Result> results;
+    bool allLossless = true;
+    for (const Signal& signal : signals) {
+        Result result = signal.bits == 16 ? run<int16_t>(signal, seconds) : run<int32_t>(signal, seconds);
+        cout << result.name << " (int" << result.bits << "): ratio " << result.ratio << ", encode "
+             << result.encodeMBps << " MB/s, decode " << result.decodeMBps << " MB/s"
+             << (result.lossless ? "" : ", ROUND TRIP FAILED") << endl;
+        allLossless = allLossless && result.lossless;
+        results.push_back(result);
+    }
+    bool passThrough = checkPassThrough(random);
+    cout << "24-bit audio stored as int32: " << (passThrough ? "codes unchanged" : "CODES CHANGED") << endl;
+    allLossless = allLossless && passThrough;
+
+    cout << "Parallel compression, 16 x 24-bit channels, " << thread::hardware_concurrency() << " cores:" << endl;
+    vector<ScalingResult> scaling;
+    for (size_t threads : threadCounts) {
+        ScalingResult result = runParallel(threads, seconds, random);
+        cout << "  " << result.threads << " thread(s): " << result.MBps << " MB/s";
+        if (!scaling.empty()) {
+            cout << " (" << result.MBps / scaling.front().MBps << "x)";
+        }
+        cout << endl;
+        scaling.push_back(result);
+    }
+
+    writeJson(jsonPath, results, scaling);
+    cout << "Results written to " << jsonPath << endl;
+    return allLossless ? 0 : 1;
+}
@@ -0,0 +1,166 @@
+// IoLatencyBench.cpp
+// Per-block write latency of BufferedFile through the page cache and with O_DIRECT.
+// A writer thread appends fixed-size blocks, optionally paced to a data rate, and
+// rotates files like the recorder does; each block's time includes any write(2)
+// or rotation it triggers. Long buffered runs let dirty pages pile up until the
+// kernel's writeback throttles the writer, which shows in the high percentiles.
+// The peak of "Dirty:" in /proc/meminfo is reported alongside.
+//
+// Usage: io_latency_bench [--megabytes 2048] [--block-kb 256] [--file-mb 256] [--rate 0]
+//                         [--dir bench_output/io_latency] [--json bench_output/io_latency_bench.json]
+#include "../include/BufferedFile.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <filesystem>
+#include <unistd.h>
+
+using namespace std;
+namespace fs = filesystem;
+
+// Results of one I/O mode.
+struct Result {
+    string mode;
+    double p50Ms;
+    double p90Ms;
+    double p99Ms;
+    double p999Ms;
+    double maxMs;
+    double MBps;        // Until the last block was handed over
+    double syncMs;      // Final sync(2), the data still to be written back
+    double peakDirtyMB;
+};
+
+// Dirty page cache in MB, from /proc/meminfo.
+static double dirtyMB() {
+    ifstream meminfo("/proc/meminfo");
+    string key;
+    double value;
+    string unit;
+    while (meminfo >> key >> value >> unit) {
+        if (key == "Dirty:") {
+            return value / 1024.0;
+        }
+    }
+    return 0;
+}
+
+static double percentile(const vector<double>& sorted, double fraction) {
+    size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[min(index, sorted.size() - 1)];
+}
+
+static Result run(const string& name, BufferedFile::IoMode mode, const string& dir, size_t totalBytes,
+                  size_t blockBytes, size_t fileBytes, double rateMBps) {
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    vector<char> block(blockBytes);
+    for (size_t i = 0; i < block.size(); ++i) {
+        block[i] = static_cast<char>(i * 31 + i / 4096);
+    }
+
+    const size_t blocks = max<size_t>(totalBytes / blockBytes, 1);
+    vector<double> latencies;
+    latencies.reserve(blocks);
+    double peakDirty = dirtyMB();
+    auto interval = chrono::duration<double>(rateMBps > 0 ? blockBytes / (rateMBps * 1e6) : 0);
+
+    BufferedFile file;
+    file.setIoMode(mode);
+    size_t fileIndex = 0;
+    size_t inFile = fileBytes;
+    auto start = chrono::steady_clock::now();
+    for (size_t b = 0; b < blocks; ++b) {
+        if (rateMBps > 0) {
+            this_thread::sleep_until(start + chrono::duration_cast<chrono::steady_clock::duration>(interval * b));
+        }
+        auto before = chrono::steady_clock::now();
+        if (inFile >= fileBytes) {
+            file.open(dir + "/segment" + to_string(fileIndex++) + ".bin");
+            inFile = 0;
+        }
+        file.sputn(block.data(), block.size());
+        inFile += block.size();
+        latencies.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - before).count());
+        if (b % 16 == 0) {
+            peakDirty = max(peakDirty, dirtyMB());
+        }
+    }
+    file.close();
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    auto syncStart = chrono::steady_clock::now();
+    sync();
+    double syncMs = chrono::duration<double, milli>(chrono::steady_clock::now() - syncStart).count();
+    fs::remove_all(dir);
+
+    sort(latencies.begin(), latencies.end());
+    return { name, percentile(latencies, 0.5), percentile(latencies, 0.9), percentile(latencies, 0.99),
+             percentile(latencies, 0.999), latencies.back(), blockBytes * blocks / elapsed / 1e6, syncMs, peakDirty };
+}
+
+static void writeJson(const string& path, const vector<Result>& results, size_t totalBytes, size_t blockBytes,
+                      size_t fileBytes, double rateMBps) {
+    fs::path parent = fs::path(path).parent_path();
+    if (!parent.empty()) {
+        fs::create_directories(parent);
+    }
+    ofstream json(path);
+    json << "{\n  \"benchmark\": \"io_latency\",\n  \"megabytes\": " << totalBytes / (1 << 20)
+         << ",\n  \"block_kb\": " << blockBytes / 1024 << ",\n  \"file_mb\": " << fileBytes / (1 << 20)
+         << ",\n  \"rate_MBps\": " << rateMBps << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        json << "    {\"mode\": \"" << r.mode << "\", \"p50_ms\": " << r.p50Ms << ", \"p90_ms\": " << r.p90Ms
+             << ", \"p99_ms\": " << r.p99Ms << ", \"p99.9_ms\": " << r.p999Ms << ", \"max_ms\": " << r.maxMs
+             << ", \"MBps\": " << r.MBps << ", \"sync_ms\": " << r.syncMs << ", \"peak_dirty_MB\": " << r.peakDirtyMB
+             << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    json << "  ]\n}\n";
+}
+
+int main(int argc, char** argv) {
+    size_t megabytes = 2048;
+    size_t blockKB = 256;
+    size_t fileMB = 256;
+    double rateMBps = 0;
+    string dir = "bench_output/io_latency";
+    string jsonPath = "bench_output/io_latency_bench.json";
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string option = argv[i];
+        if (option == "--megabytes") {
+            megabytes = stoul(argv[i + 1]);
+        } else if (option == "--block-kb") {
+            blockKB = stoul(argv[i + 1]);
+        } else if (option == "--file-mb") {
+            fileMB = stoul(argv[i + 1]);
+        } else if (option == "--rate") {
+            rateMBps = stod(argv[i + 1]);
+        } else if (option == "--dir") {
+            dir = argv[i + 1];
+        } else if (option == "--json") {
+            jsonPath = argv[i + 1];
+        }
+    }
+    const size_t totalBytes = megabytes << 20;
+    const size_t blockBytes = max<size_t>(blockKB, 1) * 1024;
+    const size_t fileBytes = max<size_t>(fileMB, 1) << 20;
+
+    cout << "I/O latency benchmark: " << megabytes << " MB in " << blockKB << " KB blocks, "
+         << fileMB << " MB files, " << (rateMBps > 0 ? to_string(rateMBps) + " MB/s" : string("unpaced")) << endl;
+    vector<Result> results;
+    results.push_back(run("buffered", BufferedFile::IoMode::Buffered, dir, totalBytes, blockBytes, fileBytes, rateMBps));
+    results.push_back(run("direct", BufferedFile::IoMode::Direct, dir, totalBytes, blockBytes, fileBytes, rateMBps));
+    for (const Result& r : results) {
+        cout << r.mode << ": p50 " << r.p50Ms << " ms, p90 " << r.p90Ms << " ms, p99 " << r.p99Ms
+             << " ms, p99.9 " << r.p999Ms << " ms, max " << r.maxMs << " ms, " << r.MBps << " MB/s, final sync "
+             << r.syncMs << " ms, peak dirty " << r.peakDirtyMB << " MB" << endl;
+    }
+
+    writeJson(jsonPath, results, totalBytes, blockBytes, fileBytes, rateMBps);
+    cout << "Results written to " << jsonPath << endl;
+    return 0;
+}
@@ -0,0 +1,339 @@
+// PipelineBench.cpp
+// End-to-end throughput of the acquisition pipeline: simulated NiDAQ and audio
+// sources -> BlockRing -> Pipeline -> AsyncWriter -> the real file writers.
+// For every writer, channel count and sample rate it reports sustained samples/s,
+// bytes/s, per-block latency (ring commit to file write) percentiles, CPU% and
+// peak RSS, and writes all results as JSON for regression tracking. The run fails
+// if a NiDAQ task is given a WAV writer, which would clamp its samples to PCM.
+//
+// Usage: pipeline_bench [--writers csv,binary] [--channels 1,4,16,64]
+//                       [--rates 1000,10000,100000,1000000] [--seconds 2]
+//                       [--audio-writers csv,binary,wav] [--json bench_output/pipeline_bench.json]
+#include "../include/NiDAQ.h"
+#include "../include/AudioDAQ.h"
+#include "../include/Pipeline.h"
+#include "../include/CSVWriter.h"
+#include "../include/BinaryWriter.h"
+#include "../include/WavWriter.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+#include <cstdlib>
+#include <sys/resource.h>
+
+using namespace std;
+namespace fs = filesystem;
+
+// Results shared between a TimingWriter on the writer thread and the benchmark.
+struct WriteStats {
+    uint64_t samples = 0;          // Samples handed to the file writer
+    vector<double> latencyMs;      // Ring commit to write completion, per block
+};
+
+// Wraps a file writer and records what it wrote and how late.
+class TimingWriter : public DataWriter {
+public:
+    TimingWriter(unique_ptr<DataWriter> writer, WriteStats& stats) : writer(move(writer)), stats(stats) {}
+
+    void addDataBlock(DataBlock&& block) override {
+        int64_t committed = block.committedNs;
+        stats.samples += block.size();
+        writer->addDataBlock(move(block));
+        int64_t now = chrono::duration_cast<chrono::nanoseconds>(
+            chrono::steady_clock::now().time_since_epoch()).count();
+        stats.latencyMs.push_back((now - committed) / 1e6);
+    }
+    using DataWriter::addDataBlock;
+
+    void updateFilename() override {
+        writer->updateFilename();
+    }
+
+private:
+    unique_ptr<DataWriter> writer;
+    WriteStats& stats;
+};
+
+// One benchmark case and its measurements.
+struct Result {
+    string source;        // "nidaq" or "audio"
+    string writer;        // "csv", "binary" or "wav"
+    string pacing;        // "realtime" or "fast"
+    int channels = 0;
+    unsigned int rate = 0;
+    double seconds = 0;   // Wall time including draining the writer
+    uint64_t samples = 0;
+    uint64_t bytes = 0;
+    uint64_t blocks = 0;
+    uint64_t droppedBlocks = 0;
+    double p50 = 0, p90 = 0, p99 = 0, maxLatency = 0;
+    double cpuPercent = 0;
+    long peakRssKB = 0;
+    bool sustained = false;
+};
+
+static vector<string> splitList(const string& text) {
+    vector<string> items;
+    stringstream stream(text);
+    string item;
+    while (getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+static double cpuSeconds() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+// Resets the peak resident set size so each case reports its own (Linux 4.0+).
+static void resetPeakRss() {
+    ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+}
+
+static long peakRssKB() {
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return atol(line.c_str() + 6);
+        }
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static uint64_t directoryBytes(const string& dir) {
+    uint64_t total = 0;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        total += entry.file_size();
+    }
+    return total;
+}
+
+static double percentile(vector<double>& values, double fraction) {
+    if (values.empty()) {
+        return 0;
+    }
+    size_t index = min(values.size() - 1, static_cast<size_t>(fraction * (values.size() - 1) + 0.5));
+    nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+// Returns null if `source` cannot be written in `format`.
+static unique_ptr<DataWriter> createWriter(const string& format, const AcquisitionSource& source, const string& dir) {
+    const vector<ChannelInfo> channels = source.getChannels();
+    const unsigned int rate = source.getSampleRate();
+    if (format == "binary") {
+        return make_unique<BinaryWriter>(channels, rate, dir, "bench");
+    }
+    if (format == "wav") {
+        AudioFormat::Encoding encoding;
+        if (!WavWriter::checkSource(source, "bench", encoding)) {
+            return nullptr;
+        }
+        return make_unique<WavWriter>(static_cast<int>(channels.size()), rate, dir, "bench", encoding);
+    }
+    auto csv = make_unique<CSVWriter>(static_cast<int>(channels.size()), dir, "bench");
+    csv->setScaling(channels);
+    return csv;
+}
+
+// A task of `channels` ±5 V channels in 10 ms blocks, read from EveryNSamples callbacks.
+static string writeNiDAQIni(const string& path, int channels, unsigned int rate) {
+    unsigned int blockSamples = max(1u, rate / 100);
+    ofstream ini(path);
+    for (int c = 0; c < channels; ++c) {
+        char name[16];
+        snprintf(name, sizeof(name), "ai%02d", c);
+        ini << "[DAQmxChannel Bench/" << name << "]\n"
+            << "AI.MeasType = Voltage\nAI.Max = 5\nAI.Min = -5\nChanType = Analog Input\n"
+            << "PhysicalChanName = SimMod1/" << name << "\n\n";
+    }
+    ini << "[DAQmxTask Bench]\nSampClk.Rate = " << rate << "\nSampQuant.SampPerChan = " << blockSamples << "\n\n"
+        << "[NiDAQ]\nmode = callback\nblockSamples = " << blockSamples << "\ninputBufferSamples = " << rate * 2 << "\n";
+    return path;
+}
+
+static string writeAudioIni(const string& path, unsigned int rate, const string& pacing) {
+    ofstream ini(path);
+    ini << "[AudioDAQ]\ndevice=sim:noise\nsampleRate=" << rate << "\nsampleType=int16\npacing=" << pacing << "\n";
+    return path;
+}
+
+// Runs one source through the pipeline for `seconds`, then drains and measures.
+static Result runCase(AcquisitionSource& source, const string& iniPath, const string& writerName,
+                      const string& pacing, double seconds) {
+    Result result;
+    result.writer = writerName;
+    result.pacing = pacing;
+    string dir = "bench_output/pipeline";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    resetPeakRss();
+
+    if (!source.configure(iniPath.c_str())) {
+        cerr << "Cannot configure the simulated source from " << iniPath << endl;
+        return result;
+    }
+    result.channels = static_cast<int>(source.getChannels().size());
+    result.rate = source.getSampleRate();
+
+    WriteStats stats;
+    double cpuBefore = cpuSeconds();
+    auto start = chrono::steady_clock::now();
+    {
+        // No rotation: fast runs would rotate several times per second and reuse file names
+        Pipeline pipeline(false);
+        unique_ptr<DataWriter> fileWriter = createWriter(writerName, source, dir);
+        if (!fileWriter) {
+            return result;
+        }
+        auto writer = make_unique<TimingWriter>(move(fileWriter), stats);
+        pipeline.addStream("bench", &source, make_unique<AsyncWriter>(move(writer), 8, AsyncWriter::Policy::Block, dir + "/bench.spill"));
+        if (!source.start()) {
+            cerr << "Cannot start the simulated source." << endl;
+            return result;
+        }
+        while (chrono::duration<double>(chrono::steady_clock::now() - start).count() < seconds) {
+            pipeline.waitAndService(50);
+        }
+        pipeline.stopAll();
+        pipeline.serviceAll();
+        result.blocks = source.getBlockCount();
+        result.droppedBlocks = source.getDroppedBlocks();
+    } // The AsyncWriter drains its queue and closes the file here
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    result.cpuPercent = 100.0 * (cpuSeconds() - cpuBefore) / result.seconds;
+    result.peakRssKB = peakRssKB();
+
+    result.samples = stats.samples;
+    result.bytes = directoryBytes(dir);
+    result.p50 = percentile(stats.latencyMs, 0.50);
+    result.p90 = percentile(stats.latencyMs, 0.90);
+    result.p99 = percentile(stats.latencyMs, 0.99);
+    result.maxLatency = stats.latencyMs.empty() ? 0 : *max_element(stats.latencyMs.begin(), stats.latencyMs.end());
+
+    // Sustained: nothing dropped and, in real time, at least 95% of the expected samples arrived
+    double expected = seconds * result.rate * result.channels;
+    bool paced = result.pacing != "fast";
+    result.sustained = result.droppedBlocks == 0 && (!paced || result.samples >= 0.95 * expected);
+    fs::remove_all(dir);
+    return result;
+}
+
+static void printResult(const Result& r) {
+    cout << r.source << " " << r.writer << " " << r.pacing << " " << r.channels << " ch @ " << r.rate << " S/s: "
+         << r.samples / r.seconds / 1e6 << " MS/s, " << r.bytes / r.seconds / 1e6 << " MB/s, latency p50/p99 "
+         << r.p50 << "/" << r.p99 << " ms, CPU " << r.cpuPercent << "%, RSS " << r.peakRssKB / 1024 << " MB, dropped "
+         << r.droppedBlocks << (r.sustained ? "" : " (not sustained)") << endl;
+}
+
+static void writeJson(const string& path, const vector<Result>& results, double seconds) {
+    ofstream json(path);
+    json << "{\n  \"benchmark\": \"pipeline\",\n  \"seconds\": " << seconds << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        json << "    {\"source\": \"" << r.source << "\", \"writer\": \"" << r.writer << "\", \"pacing\": \"" << r.pacing
+             << "\", \"channels\": " << r.channels << ", \"rate\": " << r.rate
+             << ", \"samples_per_s\": " << r.samples / r.seconds << ", \"bytes_per_s\": " << r.bytes / r.seconds
+             << ", \"latency_ms\": {\"p50\": " << r.p50 << ", \"p90\": " << r.p90 << ", \"p99\": " << r.p99
+             << ", \"max\": " << r.maxLatency << "}, \"cpu_percent\": " << r.cpuPercent
+             << ", \"peak_rss_kb\": " << r.peakRssKB << ", \"blocks\": " << r.blocks
+             << ", \"dropped_blocks\": " << r.droppedBlocks << ", \"sustained\": " << (r.sustained ? "true" : "false")
+             << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    json << "  ]\n}\n";
+}
+
+int main(int argc, char** argv) {
+    vector<string> writers = { "csv", "binary" };
+    vector<string> audioWriters = { "csv", "binary", "wav" };
+    vector<string> channelList = { "1", "4", "16", "64" };
+    vector<string> rateList = { "1000", "10000", "100000", "1000000" };
+    double seconds = 2.0;
+    string jsonPath = "bench_output/pipeline_bench.json";
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string option = argv[i];
+        string value = argv[i + 1];
+        if (option == "--writers") {
+            writers = splitList(value);
+        } else if (option == "--audio-writers") {
+            audioWriters = splitList(value);
+        } else if (option == "--channels") {
+            channelList = splitList(value);
+        } else if (option == "--rates") {
+            rateList = splitList(value);
+        } else if (option == "--seconds") {
+            seconds = stod(value);
+        } else if (option == "--json") {
+            jsonPath = value;
+        } else {
+            cerr << "Unknown option: " << option << endl;
+            return 1;
+        }
+    }
+    fs::create_directories("bench_output");
+    string niIni = "bench_output/pipeline_nidaq.ini";
+    string audioIni = "bench_output/pipeline_audio.ini";
+    vector<Result> results;
+
+    // Scaled NI readings must not be accepted by the WAV writer
+    {
+        NiDAQHandler source;
+        if (source.configure(writeNiDAQIni(niIni, 2, 1000).c_str()) && createWriter("wav", source, "bench_output")) {
+            cerr << "WAV output was accepted for a NiDAQ task." << endl;
+            return 1;
+        }
+    }
+
+    // NiDAQ: every writer, channel count and rate in real time, then as fast as possible
+    for (const string& writer : writers) {
+        for (const string& channels : channelList) {
+            for (const string& rate : rateList) {
+                setenv("DAQMX_SIM_PACING", "realtime", 1);
+                NiDAQHandler source;
+                Result r = runCase(source, writeNiDAQIni(niIni, stoi(channels), stoul(rate)), writer, "realtime", seconds);
+                r.source = "nidaq";
+                printResult(r);
+                results.push_back(r);
+            }
+            setenv("DAQMX_SIM_PACING", "fast", 1);
+            NiDAQHandler source;
+            Result r = runCase(source, writeNiDAQIni(niIni, stoi(channels), stoul(rateList.back())), writer, "fast", seconds);
+            r.source = "nidaq";
+            printResult(r);
+            results.push_back(r);
+        }
+    }
+
+    // Audio: 48 kHz in real time, then the simulated card as fast as the writers keep up
+    for (const string& writer : audioWriters) {
+        for (const char* pacing : { "realtime", "fast" }) {
+            AudioDAQ source;
+            Result r = runCase(source, writeAudioIni(audioIni, 48000, pacing), writer, pacing, seconds);
+            r.source = "audio";
+            printResult(r);
+            results.push_back(r);
+        }
+    }
+
+    fs::remove(niIni);
+    fs::remove(audioIni);
+    writeJson(jsonPath, results, seconds);
+    cout << "Results written to " << jsonPath << endl;
+    return 0;
+}
@@ -0,0 +1,67 @@
+#ifndef ACQUISITION_SOURCE_H
+#define ACQUISITION_SOURCE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "ChannelInfo.h"
+#include "DataBlock.h"
+#include "AudioFormat.h"
+
+using namespace std;
+
+// AcquisitionSource is the common interface of every device the program records
+// from (NI-DAQmx tasks, ALSA sound cards, ...). The pipeline only talks to this
+// interface, so new device types plug in without touching main.cpp.
+class AcquisitionSource {
+public:
+    virtual ~AcquisitionSource() = default;
+
+    // Loads the device settings from an INI file and prepares the hardware.
+    virtual bool configure(const char* filename) = 0;
+
+    // Starts acquisition on the device's own thread.
+    virtual bool start() = 0;
+
+    // Stops acquisition and releases the hardware.
+    virtual void stop() = 0;
+
+    // Moves the oldest unread block of interleaved samples into `block`,
+    // in the source's native format. Returns false when no block is ready.
+    virtual bool readBlock(DataBlock& block) = 0;
+
+    // Descriptor that becomes readable when a block is ready.
+    virtual int getEventFd() const = 0;
+
+    // Clears the event descriptor and returns how many blocks were signaled since the last call.
+    virtual uint64_t drainEvents() = 0;
+
+    // Sampling rate in Hz.
+    virtual unsigned int getSampleRate() const = 0;
+
+    // Name, units and range of each channel in the interleaved blocks.
+    virtual vector<ChannelInfo> getChannels() const = 0;
+
+    // Blocks acquired so far, including dropped ones.
+    virtual uint64_t getBlockCount() const = 0;
+
+    // Blocks lost because the consumer fell behind.
+    virtual uint64_t getDroppedBlocks() const = 0;
+
+    // Sets how many blocks may wait for the consumer; call before configure().
+    virtual void setRingBlocks(size_t blocks) { (void)blocks; }
+
+    // Measured sample-clock error against CLOCK_MONOTONIC_RAW in parts per million,
+    // positive when the device samples fast. Returns false until there is an estimate.
+    virtual bool getDriftPpm(double& ppm) const { (void)ppm; return false; }
+
+    // When set, block timestamps come from the fitted drift model instead of the
+    // nominal rate, so blocks of different devices stay aligned over long runs.
+    // Call before start().
+    virtual void setAlignTimestamps(bool align) { (void)align; }
+
+    // Sample encoding of sources that capture PCM audio. Returns false for other sources.
+    virtual bool getAudioEncoding(AudioFormat::Encoding& encoding) const { (void)encoding; return false; }
+};
+
+#endif // ACQUISITION_SOURCE_H
@@ -0,0 +1,202 @@
+#include "AsyncWriter.h"
+#include <iostream>
+#include <algorithm>
+#include <cstdio>
+
+// Constructor: Starts the background writer thread.
+AsyncWriter::AsyncWriter(unique_ptr<DataWriter> writer, size_t capacity, Policy policy, const string& spillFilename)
+    : writer(move(writer)), capacity(max<size_t>(capacity, 1)), policy(policy), spillFilename(spillFilename),
+      spillPending(0), maxDepth(0), dropped(0), spilled(0), stopping(false) {
+    writerThread = thread(&AsyncWriter::writerLoop, this);
+}
+
+// Destructor: Lets the writer thread drain the queue and the overflow file.
+AsyncWriter::~AsyncWriter() {
+    {
+        lock_guard<mutex> lock(queueMutex);
+        stopping = true;
+    }
+    notEmpty.notify_all();
+    notFull.notify_all();
+    if (writerThread.joinable()) {
+        writerThread.join();
+    }
+    if (spillOut.is_open() || spillIn.is_open()) {
+        spillOut.close();
+        spillIn.close();
+        remove(spillFilename.c_str());
+    }
+}
+
+bool AsyncWriter::parsePolicy(const string& text, Policy& policy) {
+    if (text == "block") {
+        policy = Policy::Block;
+    } else if (text == "drop-oldest") {
+        policy = Policy::DropOldest;
+    } else if (text == "spill") {
+        policy = Policy::Spill;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void AsyncWriter::addDataBlock(DataBlock&& block) {
+    push({ move(block), false });
+}
+
+void AsyncWriter::updateFilename() {
+    push({ {}, true });
+}
+
+// Queues a job, applying the backpressure policy when the queue is full.
+void AsyncWriter::push(Job&& job) {
+    unique_lock<mutex> lock(queueMutex);
+
+    if (policy == Policy::Spill && (spillPending > 0 || queue.size() >= capacity)) {
+        // Once spilling has started, later jobs follow through the file to keep the order.
+        writeSpill(job);
+        spillPending++;
+        if (!job.rotate) {
+            spilled++;
+        }
+    } else {
+        if (queue.size() >= capacity) {
+            if (policy == Policy::Block) {
+                notFull.wait(lock, [this] { return queue.size() < capacity || stopping; });
+            } else if (policy == Policy::DropOldest) {
+                // Rotations are never dropped, only data.
+                auto oldest = find_if(queue.begin(), queue.end(), [](const Job& j) { return !j.rotate; });
+                if (oldest != queue.end()) {
+                    queue.erase(oldest);
+                    dropped++;
+                }
+            }
+        }
+        queue.push_back(move(job));
+        maxDepth = max(maxDepth, queue.size());
+    }
+    lock.unlock();
+    notEmpty.notify_one();
+}
+
+// Writer thread: queued jobs first, then spilled jobs, which are always newer.
+void AsyncWriter::writerLoop() {
+    while (true) {
+        Job job;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            notEmpty.wait(lock, [this] { return !queue.empty() || spillPending > 0 || stopping; });
+            if (!queue.empty()) {
+                job = move(queue.front());
+                queue.pop_front();
+            } else if (spillPending > 0) {
+                if (!readSpill(job)) {
+                    cerr << "Overflow file is corrupt, " << spillPending << " jobs lost: " << spillFilename << endl;
+                    spillPending = 0;
+                    resetSpill();
+                    continue;
+                }
+                if (--spillPending == 0) {
+                    resetSpill();
+                }
+            } else {
+                break; // Stopping and nothing left to write
+            }
+        }
+        notFull.notify_one();
+
+        if (job.rotate) {
+            writer->updateFilename();
+        } else {
+            writer->addDataBlock(move(job.block));
+        }
+    }
+}
+
+// Appends a job to the overflow file as
+// [rotate flag][sample format][sequence][timestamp][commit time][sample count][samples].
+void AsyncWriter::writeSpill(const Job& job) {
+    if (!spillOut.is_open()) {
+        spillOut.open(spillFilename, ios::binary | ios::trunc);
+        spillIn.open(spillFilename, ios::binary);
+        if (!spillOut.is_open() || !spillIn.is_open()) {
+            cerr << "Failed to open overflow file: " << spillFilename << endl;
+        }
+    }
+    uint8_t rotate = job.rotate ? 1 : 0;
+    uint8_t format = static_cast<uint8_t>(job.block.format);
+    uint64_t count = job.block.size();
+    spillOut.write(reinterpret_cast<const char*>(&rotate), sizeof(rotate));
+    spillOut.write(reinterpret_cast<const char*>(&format), sizeof(format));
+    spillOut.write(reinterpret_cast<const char*>(&job.block.sequence), sizeof(job.block.sequence));
+    spillOut.write(reinterpret_cast<const char*>(&job.block.timestampNs), sizeof(job.block.timestampNs));
+    spillOut.write(reinterpret_cast<const char*>(&job.block.committedNs), sizeof(job.block.committedNs));
+    spillOut.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    if (job.block.format == SampleFormat::Int16) {
+        spillOut.write(reinterpret_cast<const char*>(job.block.codes.data()), count * sizeof(int16_t));
+    } else if (job.block.format == SampleFormat::Int32) {
+        spillOut.write(reinterpret_cast<const char*>(job.block.wideCodes.data()), count * sizeof(int32_t));
+    } else {
+        spillOut.write(reinterpret_cast<const char*>(job.block.values.data()), count * sizeof(double));
+    }
+    spillOut.flush(); // Make the record visible to the replay side
+}
+
+// Reads the next job from the overflow file.
+bool AsyncWriter::readSpill(Job& job) {
+    uint8_t rotate = 0;
+    uint8_t format = 0;
+    uint64_t count = 0;
+    spillIn.read(reinterpret_cast<char*>(&rotate), sizeof(rotate));
+    spillIn.read(reinterpret_cast<char*>(&format), sizeof(format));
+    spillIn.read(reinterpret_cast<char*>(&job.block.sequence), sizeof(job.block.sequence));
+    spillIn.read(reinterpret_cast<char*>(&job.block.timestampNs), sizeof(job.block.timestampNs));
+    spillIn.read(reinterpret_cast<char*>(&job.block.committedNs), sizeof(job.block.committedNs));
+    spillIn.read(reinterpret_cast<char*>(&count), sizeof(count));
+    if (!spillIn) {
+        return false;
+    }
+    job.rotate = rotate != 0;
+    job.block.format = static_cast<SampleFormat>(format);
+    if (job.block.format == SampleFormat::Int16) {
+        job.block.codes.resize(count);
+        spillIn.read(reinterpret_cast<char*>(job.block.codes.data()), count * sizeof(int16_t));
+    } else if (job.block.format == SampleFormat::Int32) {
+        job.block.wideCodes.resize(count);
+        spillIn.read(reinterpret_cast<char*>(job.block.wideCodes.data()), count * sizeof(int32_t));
+    } else {
+        job.block.values.resize(count);
+        spillIn.read(reinterpret_cast<char*>(job.block.values.data()), count * sizeof(double));
+    }
+    return static_cast<bool>(spillIn);
+}
+
+// Empties the overflow file once everything in it has been replayed.
+void AsyncWriter::resetSpill() {
+    spillOut.close();
+    spillIn.close();
+    spillOut.clear();
+    spillIn.clear();
+    remove(spillFilename.c_str());
+}
+
+size_t AsyncWriter::queueDepth() {
+    lock_guard<mutex> lock(queueMutex);
+    return queue.size();
+}
+
+size_t AsyncWriter::maxQueueDepth() {
+    lock_guard<mutex> lock(queueMutex);
+    return maxDepth;
+}
+
+uint64_t AsyncWriter::droppedBlocks() {
+    lock_guard<mutex> lock(queueMutex);
+    return dropped;
+}
+
+uint64_t AsyncWriter::spilledBlocks() {
+    lock_guard<mutex> lock(queueMutex);
+    return spilled;
+}
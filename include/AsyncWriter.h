@@ -0,0 +1,82 @@
+#ifndef ASYNC_WRITER_H
+#define ASYNC_WRITER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <fstream>
+#include <cstdint>
+#include "DataWriter.h"
+
+using namespace std;
+
+// AsyncWriter moves the file I/O of another DataWriter onto a background thread.
+// Blocks are handed over through a bounded queue so the acquisition loop never
+// waits for the disk, unless the Block policy is selected and the queue is full.
+class AsyncWriter : public DataWriter {
+public:
+    // What to do when a block arrives and the queue is full.
+    enum class Policy {
+        Block,       // Wait until the writer thread frees a slot
+        DropOldest,  // Discard the oldest queued block and count it as dropped
+        Spill        // Append the block to an overflow file and replay it later in order
+    };
+
+    // Constructor: Starts the writer thread in front of `writer`.
+    AsyncWriter(unique_ptr<DataWriter> writer, size_t capacity, Policy policy, const string& spillFilename);
+
+    // Destructor: Writes everything still queued or spilled, then stops the thread.
+    ~AsyncWriter() override;
+
+    // Queues a block for the writer thread.
+    void addDataBlock(DataBlock&& block) override;
+    using DataWriter::addDataBlock;
+
+    // Queues a file rotation behind the blocks already queued.
+    void updateFilename() override;
+
+    // Parses "block", "drop-oldest" or "spill"; returns false for anything else.
+    static bool parsePolicy(const string& text, Policy& policy);
+
+    size_t queueDepth();        // Jobs currently waiting in the queue
+    size_t maxQueueDepth();     // Highest queue depth seen so far
+    uint64_t droppedBlocks();   // Blocks discarded by the DropOldest policy
+    uint64_t spilledBlocks();   // Blocks routed through the overflow file
+
+private:
+    // One unit of work for the writer thread.
+    struct Job {
+        DataBlock block;          // Samples to write
+        bool rotate;              // True for updateFilename()
+    };
+
+    unique_ptr<DataWriter> writer;  // Writer doing the actual file I/O
+    size_t capacity;                // Maximum number of queued jobs
+    Policy policy;                  // Backpressure policy
+    string spillFilename;           // Overflow file for the Spill policy
+    deque<Job> queue;               // Pending jobs, oldest first
+    size_t spillPending;            // Jobs in the overflow file not replayed yet
+    size_t maxDepth;                // Highest queue depth seen
+    uint64_t dropped;               // Blocks dropped
+    uint64_t spilled;               // Blocks spilled
+    bool stopping;                  // Set by the destructor
+    ofstream spillOut;              // Append side of the overflow file
+    ifstream spillIn;               // Replay side of the overflow file
+    mutex queueMutex;               // Protects all queue state above
+    condition_variable notEmpty;    // Signaled when work is queued
+    condition_variable notFull;     // Signaled when a slot is freed
+    thread writerThread;            // Background writer thread
+
+    void push(Job&& job);           // Applies the backpressure policy
+    void writerLoop();              // Writer thread body
+
+    void writeSpill(const Job& job);
+    bool readSpill(Job& job);
+    void resetSpill();
+};
+
+#endif // ASYNC_WRITER_H
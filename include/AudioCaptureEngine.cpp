@@ -0,0 +1,118 @@
+#include "AudioCaptureEngine.h"
+#include "AudioDAQ.h"
+#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+AudioCaptureEngine::AudioCaptureEngine(size_t threads)
+    : threadCount(max<size_t>(threads, 1)) {}
+
+AudioCaptureEngine::~AudioCaptureEngine() {
+    for (auto& worker : workers) {
+        worker->running = false;
+        worker->wakeup.notify();
+        if (worker->loop.joinable()) {
+            worker->loop.join();
+        }
+    }
+}
+
+void AudioCaptureEngine::setThreads(size_t threads) {
+    lock_guard<mutex> guard(workersLock);
+    if (workers.empty()) {
+        threadCount = max<size_t>(threads, 1);
+    }
+}
+
+// Workers start together on first use, so an engine nobody attaches to costs no threads.
+void AudioCaptureEngine::attach(AudioDAQ* device) {
+    Worker* target = nullptr;
+    {
+        lock_guard<mutex> guard(workersLock);
+        if (workers.empty()) {
+            for (size_t i = 0; i < threadCount; ++i) {
+                workers.push_back(make_unique<Worker>());
+                Worker& worker = *workers.back();
+                worker.running = true;
+                worker.loop = thread(&AudioCaptureEngine::run, this, ref(worker));
+            }
+            cout << "Audio capture engine started with " << threadCount << " thread(s)." << endl;
+        }
+        for (auto& worker : workers) {
+            lock_guard<mutex> workerGuard(worker->lock);
+            if (!target || worker->devices.size() < target->devices.size()) {
+                target = worker.get();
+            }
+        }
+    }
+
+    lock_guard<mutex> guard(target->lock);
+    target->devices.push_back(device);
+    target->changed = true;
+    target->wakeup.notify();
+}
+
+// The worker holds its lock while servicing, so taking it here waits out any pass in progress.
+void AudioCaptureEngine::detach(AudioDAQ* device) {
+    lock_guard<mutex> guard(workersLock);
+    for (auto& worker : workers) {
+        lock_guard<mutex> workerGuard(worker->lock);
+        auto it = find(worker->devices.begin(), worker->devices.end(), device);
+        if (it != worker->devices.end()) {
+            worker->devices.erase(it);
+            worker->changed = true;
+            worker->wakeup.notify();
+            return;
+        }
+    }
+}
+
+void AudioCaptureEngine::run(Worker& worker) {
+    // Descriptors of device i are fds[first[i], first[i] + count[i]); fds[0] is the wakeup
+    vector<struct pollfd> fds;
+    vector<AudioDAQ*> devices;
+    vector<size_t> first;
+    vector<unsigned int> count;
+    bool rebuild = true;
+
+    while (worker.running) {
+        if (rebuild) {
+            lock_guard<mutex> guard(worker.lock);
+            devices = worker.devices;
+            worker.changed = false;
+            fds.assign(1, { worker.wakeup.fd(), POLLIN, 0 });
+            first.clear();
+            count.clear();
+            for (AudioDAQ* device : devices) {
+                unsigned int n = device->pollDescriptorCount();
+                first.push_back(fds.size());
+                count.push_back(n);
+                fds.resize(fds.size() + n);
+                device->pollDescriptors(&fds[first.back()], n);
+            }
+            rebuild = false;
+        }
+
+        // The timeout only bounds how long a broken device can go unnoticed
+        int ready = poll(fds.data(), fds.size(), 1000);
+        if (ready < 0) {
+            if (errno != EINTR) {
+                cerr << "Audio capture poll failed: " << strerror(errno) << endl;
+            }
+            continue;
+        }
+        if (fds[0].revents & POLLIN) {
+            worker.wakeup.drain();
+        }
+
+        lock_guard<mutex> guard(worker.lock);
+        if (worker.changed) {
+            rebuild = true; // A device may have been detached; its descriptors are stale
+            continue;
+        }
+        for (size_t i = 0; i < devices.size(); ++i) {
+            devices[i]->servicePoll(&fds[first[i]], count[i]);
+        }
+    }
+}
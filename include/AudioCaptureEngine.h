@@ -0,0 +1,59 @@
+#ifndef AUDIO_CAPTURE_ENGINE_H
+#define AUDIO_CAPTURE_ENGINE_H
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <poll.h>
+#include "EventNotifier.h"
+
+using namespace std;
+
+class AudioDAQ;
+
+// AudioCaptureEngine services many AudioDAQ devices from a small pool of threads
+// instead of one blocking thread per sound card. Each worker polls the non-blocking
+// PCM descriptors of its devices (snd_pcm_poll_descriptors) and reads whatever is
+// available when one becomes ready.
+class AudioCaptureEngine {
+public:
+    // Constructor: Uses `threads` workers (at least one), started on first attach().
+    explicit AudioCaptureEngine(size_t threads = 1);
+
+    // Destructor: Stops every worker.
+    ~AudioCaptureEngine();
+
+    AudioCaptureEngine(const AudioCaptureEngine&) = delete;
+    AudioCaptureEngine& operator=(const AudioCaptureEngine&) = delete;
+
+    // Sets the number of workers; only effective before the first attach().
+    void setThreads(size_t threads);
+
+    // Starts servicing a started device on the least loaded worker.
+    void attach(AudioDAQ* device);
+
+    // Stops servicing a device; the worker no longer touches it once this returns.
+    void detach(AudioDAQ* device);
+
+private:
+    // One polling thread and the devices it owns.
+    struct Worker {
+        thread loop;                     // Runs run(worker)
+        mutex lock;                      // Guards `devices` and `changed`; held while servicing
+        vector<AudioDAQ*> devices;       // Devices polled by this worker
+        bool changed = false;            // `devices` changed since the last poll set was built
+        atomic<bool> running{false};     // Cleared to stop the loop
+        EventNotifier wakeup;            // Interrupts poll() after attach/detach/stop
+    };
+
+    size_t threadCount;                  // Workers to create
+    vector<unique_ptr<Worker>> workers;  // Created on first attach()
+    mutex workersLock;                   // Guards creation of `workers`
+
+    // Worker loop: poll every device's descriptors and service the ready ones.
+    void run(Worker& worker);
+};
+
+#endif // AUDIO_CAPTURE_ENGINE_H
@@ -1,5 +1,6 @@
 // AudioDAQ.cpp
 #include "AudioDAQ.h"
+#include "AudioCaptureEngine.h"
 
 // Callback function for handling parsed INI file data
 static int handler(void* user, const char* section, const char* name, const char* value) {
@@ -21,6 +22,17 @@ std::vector<std::string> filterSections(
     return result;
 }
 
+// ALSA format matching an encoding
+static snd_pcm_format_t alsaFormat(AudioFormat::Encoding encoding) {
+    switch (encoding) {
+        case AudioFormat::Encoding::S16:       return SND_PCM_FORMAT_S16_LE;
+        case AudioFormat::Encoding::S24:       return SND_PCM_FORMAT_S24_LE;
+        case AudioFormat::Encoding::S24Packed: return SND_PCM_FORMAT_S24_3LE;
+        case AudioFormat::Encoding::S32:       return SND_PCM_FORMAT_S32_LE;
+        default:                               return SND_PCM_FORMAT_FLOAT_LE;
+    }
+}
+
 // Constructor: Initialize member variables and allocate ALSA hardware parameters
 AudioDAQ::AudioDAQ()
     : pcmHandle(nullptr),                     // PCM handle for ALSA device
@@ -28,11 +40,33 @@ AudioDAQ::AudioDAQ()
       choice(0),                              // Default device choice
       devices(),                              // List of audio devices
       selectedDevice(""),                     // Selected device name
-      buffer(),                               // Buffer to store audio data
+      ring(),                                 // Ring of captured blocks
+      overrunBuffer(),                        // Scratch block for overruns
+      ringBlocks(8),                          // Blocks in the ring
       sampleRate(0),                          // Sampling rate in Hz
+      channels(1),                            // Mono
+      encoding(AudioFormat::Encoding::S16),   // S16_LE samples
+      mmapAccess(false),                      // Read access unless the INI asks for mmap
+      periodFrames(0),                        // Driver default period size
+      bufferFrames(0),                        // Driver default buffer size
+      blockFrames(0),                         // One-second blocks
+      sampleFormat(SampleFormat::Float64),    // Format handed to the consumer
       times(0),                               // Number of captured data chunks
       capturing(false),                       // Capture state flag
-      captureThread() {                       // Thread for capturing audio data
+      simulated(false),                       // Capture from a sound card
+      simPacing(SimulatedCapture::Pacing::Realtime), // Simulated source runs in real time
+      simulator(),                            // Simulated source, unused for sound cards
+      captureThread(),                        // Thread for capturing audio data
+      captureEngine(nullptr),                 // Own capture thread
+      pendingSlot(nullptr),                   // No block in progress
+      pendingTarget(nullptr),
+      pendingFrames(0),
+      hardwareTimestamps(false),              // Until configureDevice() enables them
+      captureStartNs(0),
+      framesCaptured(0),
+      drift(),                                // Rate set when capture starts
+      alignTimestamps(false),                 // Per-block timestamps
+      blockReady() {                          // Block-ready notification
     snd_pcm_hw_params_alloca(&hwParams);
 }
 
@@ -87,9 +121,19 @@ void AudioDAQ::selectDevice(int choice) {
     }
 
     selectedDevice = "hw:" + std::to_string(devices[choice].card);
+    simulated = false;
     std::cout << "Selected device: " << devices[choice].name << std::endl;
 }
 
+// Select a simulated source; no sound card is touched
+void AudioDAQ::selectSimulatedDevice(const std::string& device, SimulatedCapture::Pacing pacing) {
+    selectedDevice = device;
+    simulated = true;
+    simPacing = pacing;
+    std::cout << "Selected device: " << device
+              << (pacing == SimulatedCapture::Pacing::Fast ? " (faster than real time)" : "") << std::endl;
+}
+
 // Initialize devices with settings from an INI configuration file
 void AudioDAQ::initDevices(const char* filename) {
     std::map<std::string, std::map<std::string, std::string>> ini_data;
@@ -100,18 +144,51 @@ void AudioDAQ::initDevices(const char* filename) {
     }
 
     auto filtered_sections = filterSections(ini_data, "AudioDAQ");
+    std::string device;
+    SimulatedCapture::Pacing pacing = SimulatedCapture::Pacing::Realtime;
 
     try {
         for (const auto& section : filtered_sections) {
-            choice = std::stoi(ini_data[section]["device"]);
+            // "device" is a card index, or "sim:..." for a simulated source
+            device = ini_data[section]["device"];
+            if (!SimulatedCapture::isSimulated(device)) {
+                choice = std::stoi(device);
+            } else if (!ini_data[section]["pacing"].empty() &&
+                       !SimulatedCapture::parsePacing(ini_data[section]["pacing"], pacing)) {
+                std::cerr << "Unknown pacing: " << ini_data[section]["pacing"] << ", using realtime." << std::endl;
+            }
             sampleRate = std::stoi(ini_data[section]["sampleRate"]);
+            // One PCM handle captures every channel of the card; "format" is an ALSA format name
+            AudioFormat::Encoding format = AudioFormat::Encoding::S16;
+            const std::string& formatName = ini_data[section]["format"];
+            if (!formatName.empty() && !AudioFormat::parse(formatName, format)) {
+                std::cerr << "Unknown format: " << formatName << ", using S16_LE." << std::endl;
+            }
+            const std::string& channelCount = ini_data[section]["channels"];
+            setFormat(channelCount.empty() ? 1 : std::stoul(channelCount), format);
+            // "raw" (or "int16"/"int32") keeps the native integer samples all the way to the writer
+            const std::string& sampleType = ini_data[section]["sampleType"];
+            bool raw = sampleType == "raw" || sampleType == "int16" || sampleType == "int32";
+            sampleFormat = raw ? AudioFormat::nativeFormat(encoding) : SampleFormat::Float64;
+            // "access=mmap" copies straight out of the DMA buffer; sizes are in frames, empty keeps the default
+            setMmapAccess(ini_data[section]["access"] == "mmap");
+            const std::string& period = ini_data[section]["periodFrames"];
+            const std::string& buffer = ini_data[section]["bufferFrames"];
+            const std::string& block = ini_data[section]["blockFrames"];
+            setBufferSizes(period.empty() ? 0 : std::stoul(period),
+                           buffer.empty() ? 0 : std::stoul(buffer),
+                           block.empty() ? 0 : std::stoul(block));
             std::cout << "Loaded config from section: " << section << std::endl;
         }
     } catch (const std::exception& e) {
         std::cerr << "Error parsing INI file: " << e.what() << std::endl;
     }
 
-    selectDevice(choice);
+    if (SimulatedCapture::isSimulated(device)) {
+        selectSimulatedDevice(device, pacing);
+    } else {
+        selectDevice(choice);
+    }
     configureDevice(sampleRate);
 }
 
@@ -119,19 +196,113 @@ void AudioDAQ::initDevices(const char* filename) {
 void AudioDAQ::configureDevice(unsigned int sampleRate) {
     this->sampleRate = sampleRate;
 
+    if (simulated) {
+        if (encoding != AudioFormat::Encoding::S16) {
+            std::cerr << "Simulated devices produce S16_LE, ignoring format " << AudioFormat::name(encoding) << "." << std::endl;
+            encoding = AudioFormat::Encoding::S16;
+            if (sampleFormat != SampleFormat::Float64) {
+                sampleFormat = SampleFormat::Int16;
+            }
+        }
+        if (!simulator.open(selectedDevice, sampleRate, channels, simPacing)) {
+            throw std::runtime_error("Unable to open simulated device: " + selectedDevice);
+        }
+        std::cout << "Simulated device configured with sample rate: " << sampleRate
+                  << ", " << channels << " channel(s)" << std::endl;
+        const size_t frames = blockFrames > 0 ? blockFrames : sampleRate;
+        ring.reset(ringBlocks, frames * frameBytes());
+        overrunBuffer.assign(frames * frameBytes(), 0);
+        return;
+    }
+
     if (snd_pcm_open(&pcmHandle, selectedDevice.c_str(), SND_PCM_STREAM_CAPTURE, 0) < 0) {
         throw std::runtime_error("Unable to open audio device: " + selectedDevice);
     }
 
     snd_pcm_hw_params_alloca(&hwParams);
     snd_pcm_hw_params_any(pcmHandle, hwParams);
-    snd_pcm_hw_params_set_access(pcmHandle, hwParams, SND_PCM_ACCESS_RW_INTERLEAVED);
-    snd_pcm_hw_params_set_format(pcmHandle, hwParams, SND_PCM_FORMAT_S16_LE);
-    snd_pcm_hw_params_set_channels(pcmHandle, hwParams, 1);
+    if (mmapAccess && snd_pcm_hw_params_set_access(pcmHandle, hwParams, SND_PCM_ACCESS_MMAP_INTERLEAVED) < 0) {
+        std::cerr << "Device does not support mmap access, using snd_pcm_readi." << std::endl;
+        mmapAccess = false;
+    }
+    if (!mmapAccess) {
+        snd_pcm_hw_params_set_access(pcmHandle, hwParams, SND_PCM_ACCESS_RW_INTERLEAVED);
+    }
+    if (snd_pcm_hw_params_set_format(pcmHandle, hwParams, alsaFormat(encoding)) < 0) {
+        throw std::runtime_error("Device does not support format " + std::string(AudioFormat::name(encoding)));
+    }
+    if (snd_pcm_hw_params_set_channels(pcmHandle, hwParams, channels) < 0) {
+        throw std::runtime_error("Device does not support " + std::to_string(channels) + " channels");
+    }
     snd_pcm_hw_params_set_rate_near(pcmHandle, hwParams, &this->sampleRate, nullptr);
-    snd_pcm_hw_params(pcmHandle, hwParams);
 
-    std::cout << "Device configured with sample rate: " << this->sampleRate << std::endl;
+    // The period is how often the driver wakes us, the buffer how much it holds before an overrun
+    if (bufferFrames > 0) {
+        snd_pcm_uframes_t frames = bufferFrames;
+        snd_pcm_hw_params_set_buffer_size_near(pcmHandle, hwParams, &frames);
+    }
+    if (periodFrames > 0) {
+        snd_pcm_uframes_t frames = periodFrames;
+        snd_pcm_hw_params_set_period_size_near(pcmHandle, hwParams, &frames, nullptr);
+    }
+
+    int err = snd_pcm_hw_params(pcmHandle, hwParams);
+    if (err < 0) {
+        throw std::runtime_error("Unable to configure audio device: " + std::string(snd_strerror(err)));
+    }
+
+    // Have the driver stamp every pointer update on CLOCK_MONOTONIC_RAW for snd_pcm_htimestamp
+    snd_pcm_sw_params_t* swParams;
+    snd_pcm_sw_params_alloca(&swParams);
+    hardwareTimestamps = snd_pcm_sw_params_current(pcmHandle, swParams) >= 0 &&
+                         snd_pcm_sw_params_set_tstamp_mode(pcmHandle, swParams, SND_PCM_TSTAMP_ENABLE) >= 0 &&
+                         snd_pcm_sw_params_set_tstamp_type(pcmHandle, swParams, SND_PCM_TSTAMP_TYPE_MONOTONIC_RAW) >= 0 &&
+                         snd_pcm_sw_params(pcmHandle, swParams) >= 0;
+    if (!hardwareTimestamps) {
+        std::cerr << "Device has no CLOCK_MONOTONIC_RAW timestamps, deriving block times from the sample count." << std::endl;
+    }
+
+    snd_pcm_uframes_t period = 0;
+    snd_pcm_uframes_t buffer = 0;
+    snd_pcm_hw_params_get_period_size(hwParams, &period, nullptr);
+    snd_pcm_hw_params_get_buffer_size(hwParams, &buffer);
+    std::cout << "Device configured with sample rate: " << this->sampleRate
+              << ", " << channels << " x " << AudioFormat::name(encoding)
+              << ", period " << period << " frames, buffer " << buffer << " frames"
+              << (mmapAccess ? ", mmap access" : "") << std::endl;
+
+    // Allocate every capture block up front: one second of samples per block unless blockFrames is set
+    const snd_pcm_uframes_t frames = blockFrames > 0 ? blockFrames : this->sampleRate;
+    ring.reset(ringBlocks, frames * frameBytes());
+    overrunBuffer.assign(frames * frameBytes(), 0);
+}
+
+// Set ALSA period and buffer sizes and the block size, all in frames; 0 keeps the default
+void AudioDAQ::setBufferSizes(snd_pcm_uframes_t periodFrames, snd_pcm_uframes_t bufferFrames,
+                              snd_pcm_uframes_t blockFrames) {
+    this->periodFrames = periodFrames;
+    this->bufferFrames = bufferFrames;
+    this->blockFrames = blockFrames;
+}
+
+// Choose mmap or read access for the next configureDevice()
+void AudioDAQ::setMmapAccess(bool enabled) {
+    mmapAccess = enabled;
+}
+
+// Choose the channel count and encoding for the next configureDevice()
+void AudioDAQ::setFormat(unsigned int channels, AudioFormat::Encoding encoding) {
+    this->channels = channels > 0 ? channels : 1;
+    this->encoding = encoding;
+}
+
+// Choose the engine before startCapture()
+void AudioDAQ::setCaptureEngine(AudioCaptureEngine* engine) {
+    captureEngine = engine;
+}
+
+size_t AudioDAQ::frameBytes() const {
+    return channels * AudioFormat::bytesPerSample(encoding);
 }
 
 // Start capturing audio data
@@ -140,8 +311,33 @@ void AudioDAQ::startCapture() {
         throw std::runtime_error("Capture is already running.");
     }
 
+    if (simulated) {
+        if (captureEngine && simulator.enablePolling(periodFrames) < 0) {
+            throw std::runtime_error("Unable to poll simulated device: " + selectedDevice);
+        }
+        simulator.start();
+    } else if (mmapAccess || captureEngine) {
+        // Blocking reads start the stream implicitly; mmap capture and the engine,
+        // which only reads once poll() reports data, have to start it by hand
+        if (captureEngine) {
+            snd_pcm_nonblock(pcmHandle, 1);
+        }
+        snd_pcm_prepare(pcmHandle);
+        int err = snd_pcm_start(pcmHandle);
+        if (err < 0) {
+            throw std::runtime_error("Unable to start capture: " + std::string(snd_strerror(err)));
+        }
+    }
     capturing = true;
-    captureThread = std::thread(&AudioDAQ::captureLoop, this);
+    pendingTarget = nullptr;
+    framesCaptured = 0;
+    drift.setSampleRate(sampleRate);
+    captureStartNs = monotonicRawNs();
+    if (captureEngine) {
+        captureEngine->attach(this);
+    } else {
+        captureThread = std::thread(&AudioDAQ::captureLoop, this);
+    }
     std::cout << "Capture started." << std::endl;
 }
 
@@ -149,38 +345,212 @@ void AudioDAQ::startCapture() {
 void AudioDAQ::stopCapture() {
     if (capturing) {
         capturing = false;
+        if (captureEngine) {
+            captureEngine->detach(this);
+        }
         if (captureThread.joinable()) {
             captureThread.join();
         }
+        if (pcmHandle && (mmapAccess || captureEngine)) {
+            snd_pcm_drop(pcmHandle);
+        }
         std::cout << "Capture stopped." << std::endl;
     }
 }
 
 // Main loop for capturing audio data
 void AudioDAQ::captureLoop() {
-    const int bufferSize = sampleRate;
-    short tempBuffer[bufferSize];
+    const size_t bytesPerFrame = frameBytes();
+    const snd_pcm_uframes_t bufferSize = overrunBuffer.size() / bytesPerFrame;
 
     while (capturing) {
-        int err = snd_pcm_readi(pcmHandle, tempBuffer, bufferSize);
+        // Capture straight into the next free ring slot; nothing is allocated per block.
+        // If the consumer is behind, capture into the overrun buffer and count the loss.
+        BlockRing<uint8_t>::Slot* slot = ring.beginWrite();
+        uint8_t* target = slot ? slot->data.data() : overrunBuffer.data();
+
+        snd_pcm_sframes_t err = simulated ? simulator.read(reinterpret_cast<int16_t*>(target), bufferSize)
+                              : mmapAccess ? readMmap(target, bufferSize, true)
+                                           : snd_pcm_readi(pcmHandle, target, bufferSize);
         if (err == -EPIPE) {
-            std::cerr << "Capture overrun! Audio data lost." << std::endl;
-            snd_pcm_prepare(pcmHandle);
+            recoverOverrun();
         } else if (err < 0) {
             std::cerr << "Read error: " << snd_strerror(err) << std::endl;
         } else {
-            buffer.clear();
-            for (int i = 0; i < err; ++i) {
-                buffer.push_back(static_cast<double>(tempBuffer[i]));
+            finishBlock(slot, static_cast<snd_pcm_uframes_t>(err));
+        }
+    }
+}
+
+void AudioDAQ::finishBlock(BlockRing<uint8_t>::Slot* slot, snd_pcm_uframes_t frames) {
+    int64_t timestamp = blockTimestamp(frames);
+    framesCaptured += frames;
+    if (slot) {
+        ring.commitWrite(frames * frameBytes(), timestamp);
+        blockReady.notify();
+    } else {
+        ring.markDropped();
+    }
+    times++;
+}
+
+// At htimestamp time `avail` frames were waiting behind the last frame of the block,
+// so that frame was captured avail / rate earlier, and the first one `frames` before it.
+// Without driver timestamps (or for simulated devices) the sample count is the clock,
+// and the time the read returned is what the drift estimator sees.
+int64_t AudioDAQ::blockTimestamp(snd_pcm_uframes_t frames) {
+    int64_t timestamp = captureStartNs + framesToNs(framesCaptured, sampleRate);
+    snd_pcm_uframes_t avail = 0;
+    snd_htimestamp_t stamp;
+    if (!simulated && hardwareTimestamps && snd_pcm_htimestamp(pcmHandle, &avail, &stamp) == 0 &&
+        (stamp.tv_sec != 0 || stamp.tv_nsec != 0)) {
+        int64_t stampNs = static_cast<int64_t>(stamp.tv_sec) * 1000000000 + stamp.tv_nsec;
+        timestamp = stampNs - framesToNs(avail + frames, sampleRate);
+        drift.addObservation(framesCaptured + frames + avail, stampNs);
+    } else {
+        drift.addObservation(framesCaptured + frames, monotonicRawNs());
+    }
+    if (alignTimestamps && drift.ready()) {
+        timestamp = drift.alignedNs(framesCaptured);
+    }
+    return timestamp;
+}
+
+// Only a blocking snd_pcm_readi restarts the stream by itself after prepare.
+// The frames lost in the overrun are counted as captured: capture resumes about now,
+// so framesCaptured moves up to the time elapsed since the start and the blocks that
+// follow stay on the clock instead of being stamped early by the gap.
+void AudioDAQ::recoverOverrun() {
+    std::cerr << "Capture overrun! Audio data lost." << std::endl;
+    drift.reset(); // The frame count no longer matches the device clock
+    snd_pcm_prepare(pcmHandle);
+    if (mmapAccess || captureEngine) {
+        snd_pcm_start(pcmHandle);
+    }
+    framesCaptured = std::max<uint64_t>(framesCaptured, nsToFrames(monotonicRawNs() - captureStartNs, sampleRate));
+}
+
+// Simulated devices are polled through their period timer
+unsigned int AudioDAQ::pollDescriptorCount() {
+    if (simulated) {
+        return 1;
+    }
+    int count = snd_pcm_poll_descriptors_count(pcmHandle);
+    return count > 0 ? static_cast<unsigned int>(count) : 0;
+}
+
+void AudioDAQ::pollDescriptors(struct pollfd* fds, unsigned int count) {
+    if (simulated) {
+        fds[0] = { simulator.enablePolling(periodFrames), POLLIN, 0 };
+        return;
+    }
+    snd_pcm_poll_descriptors(pcmHandle, fds, count);
+}
+
+// Fills the block in progress with whatever is ready, and returns after finishing at most one
+// block: a device with a backlog stays readable, so the engine comes straight back to it
+// without starving the other devices.
+void AudioDAQ::servicePoll(struct pollfd* fds, unsigned int count) {
+    if (simulated) {
+        if (!(fds[0].revents & POLLIN)) {
+            return;
+        }
+    } else {
+        unsigned short revents = 0;
+        snd_pcm_poll_descriptors_revents(pcmHandle, fds, count, &revents);
+        if (!(revents & (POLLIN | POLLERR))) {
+            return;
+        }
+    }
+
+    const size_t bytesPerFrame = frameBytes();
+    const snd_pcm_uframes_t blockSize = overrunBuffer.size() / bytesPerFrame;
+    while (capturing) {
+        if (!pendingTarget) {
+            pendingSlot = ring.beginWrite();
+            pendingTarget = pendingSlot ? pendingSlot->data.data() : overrunBuffer.data();
+            pendingFrames = 0;
+        }
+
+        uint8_t* target = pendingTarget + pendingFrames * bytesPerFrame;
+        snd_pcm_uframes_t wanted = blockSize - pendingFrames;
+        snd_pcm_sframes_t err = simulated ? simulator.readAvailable(reinterpret_cast<int16_t*>(target), wanted)
+                              : mmapAccess ? readMmap(target, wanted, false)
+                                           : snd_pcm_readi(pcmHandle, target, wanted);
+        if (err == 0 || err == -EAGAIN) {
+            return;
+        }
+        if (err == -EPIPE) {
+            // The frames read before the overrun end their block, so it keeps its timestamp
+            if (pendingFrames > 0) {
+                finishBlock(pendingSlot, pendingFrames);
+                pendingTarget = nullptr;
+            }
+            recoverOverrun();
+            return;
+        }
+        if (err < 0) {
+            std::cerr << "Read error: " << snd_strerror(err) << std::endl;
+            return;
+        }
+
+        pendingFrames += static_cast<snd_pcm_uframes_t>(err);
+        if (pendingFrames == blockSize) {
+            finishBlock(pendingSlot, blockSize);
+            pendingTarget = nullptr;
+            return;
+        }
+    }
+}
+
+// Copy whole periods out of the mmap'ed DMA area into `target` without a read() per period.
+// Returns the frames copied, or a negative ALSA error (-EPIPE on overrun) if none were.
+snd_pcm_sframes_t AudioDAQ::readMmap(uint8_t* target, snd_pcm_uframes_t frames, bool wait) {
+    const size_t bytesPerFrame = frameBytes();
+    snd_pcm_uframes_t filled = 0;
+
+    while (filled < frames && capturing) {
+        snd_pcm_sframes_t avail = snd_pcm_avail_update(pcmHandle);
+        if (avail < 0) {
+            return filled > 0 ? static_cast<snd_pcm_sframes_t>(filled) : avail;
+        }
+        if (avail == 0 && !wait) {
+            return filled > 0 ? static_cast<snd_pcm_sframes_t>(filled) : -EAGAIN;
+        }
+        if (avail == 0) {
+            // Sleep until the next period completes; the timeout keeps stopCapture() responsive
+            int err = snd_pcm_wait(pcmHandle, 100);
+            if (err < 0) {
+                return filled > 0 ? static_cast<snd_pcm_sframes_t>(filled) : err;
             }
-            times++;
+            continue;
+        }
+
+        // mmap_begin may shorten the chunk where the DMA buffer wraps
+        const snd_pcm_channel_area_t* areas;
+        snd_pcm_uframes_t offset;
+        snd_pcm_uframes_t chunk = std::min<snd_pcm_uframes_t>(avail, frames - filled);
+        int err = snd_pcm_mmap_begin(pcmHandle, &areas, &offset, &chunk);
+        if (err < 0) {
+            return filled > 0 ? static_cast<snd_pcm_sframes_t>(filled) : err;
         }
+
+        // Interleaved frames: frame `offset` starts `first + offset * step` bits into the area
+        const uint8_t* source = static_cast<const uint8_t*>(areas[0].addr) + (areas[0].first + offset * areas[0].step) / 8;
+        std::memcpy(target + filled * bytesPerFrame, source, chunk * bytesPerFrame);
+
+        snd_pcm_sframes_t committed = snd_pcm_mmap_commit(pcmHandle, offset, chunk);
+        if (committed < 0) {
+            return filled > 0 ? static_cast<snd_pcm_sframes_t>(filled) : committed;
+        }
+        filled += static_cast<snd_pcm_uframes_t>(committed);
     }
+    return static_cast<snd_pcm_sframes_t>(filled);
 }
 
-// Retrieve the buffer containing the captured audio data
-std::vector<double> AudioDAQ::getBuffer() const {
-    return buffer;
+// Borrow the oldest captured block; the slot returns to the capture thread when the lease ends
+AudioDAQ::BlockLease AudioDAQ::acquireBlock() {
+    return ring.acquireRead();
 }
 
 // Get the total number of data blocks captured
@@ -192,3 +562,89 @@ int AudioDAQ::getTimes() const {
 unsigned int AudioDAQ::getSampleRate() const {
     return sampleRate;
 }
+
+// Get the descriptor signaled for every captured block
+int AudioDAQ::getEventFd() const {
+    return blockReady.fd();
+}
+
+// Count the blocks signaled since the last call
+uint64_t AudioDAQ::drainEvents() {
+    return blockReady.drain();
+}
+
+// Initialize from an INI file; report failure instead of throwing
+bool AudioDAQ::configure(const char* filename) {
+    try {
+        initDevices(filename);
+    } catch (const std::exception& e) {
+        std::cerr << "AudioDAQ error: " << e.what() << std::endl;
+        return false;
+    }
+    return (pcmHandle != nullptr || simulated) && sampleRate > 0;
+}
+
+bool AudioDAQ::start() {
+    try {
+        startCapture();
+    } catch (const std::exception& e) {
+        std::cerr << "AudioDAQ error: " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void AudioDAQ::stop() {
+    stopCapture();
+}
+
+// Decode the oldest unread block into the configured format and release its slot
+bool AudioDAQ::readBlock(DataBlock& block) {
+    BlockLease lease = ring.acquireRead();
+    if (!lease) {
+        return false;
+    }
+    AudioFormat::decode(encoding, lease->data.data(), lease->count / AudioFormat::bytesPerSample(encoding),
+                        sampleFormat, block);
+    block.sequence = lease->sequence;
+    block.timestampNs = lease->timestampNs;
+    block.committedNs = lease->committedNs;
+    return true;
+}
+
+// Channels are named after the device, with "/ch<N>" appended when there is more than one
+std::vector<ChannelInfo> AudioDAQ::getChannels() const {
+    const double fullScale = AudioFormat::fullScale(encoding);
+    const bool floating = encoding == AudioFormat::Encoding::Float;
+    std::vector<ChannelInfo> result;
+    for (unsigned int c = 0; c < channels; ++c) {
+        std::string name = channels == 1 ? selectedDevice : selectedDevice + "/ch" + std::to_string(c);
+        result.push_back({ name, floating ? "FS" : "counts", floating ? -fullScale : -fullScale - 1.0, fullScale });
+    }
+    return result;
+}
+
+uint64_t AudioDAQ::getBlockCount() const {
+    return static_cast<uint64_t>(times.load());
+}
+
+uint64_t AudioDAQ::getDroppedBlocks() const {
+    return ring.droppedBlocks();
+}
+
+bool AudioDAQ::getDriftPpm(double& ppm) const {
+    return drift.ppm(ppm);
+}
+
+bool AudioDAQ::getAudioEncoding(AudioFormat::Encoding& encoding) const {
+    encoding = this->encoding;
+    return true;
+}
+
+void AudioDAQ::setAlignTimestamps(bool align) {
+    alignTimestamps = align;
+}
+
+void AudioDAQ::setRingBlocks(size_t blocks) {
+    ringBlocks = blocks > 0 ? blocks : 1;
+}
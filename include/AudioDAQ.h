@@ -9,23 +9,34 @@
 #include <atomic>
 #include <stdexcept>
 #include <cstring>
+#include <chrono>
+#include <algorithm>
 #include <alsa/asoundlib.h>
 
 // Include INIReader for configuration parsing
 #include "./iniReader/INIReader.h"
+#include "EventNotifier.h"
+#include "AcquisitionSource.h"
+#include "BlockRing.h"
+#include "SimulatedCapture.h"
+#include "AudioFormat.h"
+#include "Timestamp.h"
+#include "DriftEstimator.h"
 extern "C" {
 #include "./iniReader/ini.h"
 }
 
 using namespace std;
 
-class AudioDAQ {
+class AudioCaptureEngine;
+
+class AudioDAQ : public AcquisitionSource {
 public:
     // Constructor: Initialize the AudioDAQ object
     AudioDAQ();
 
     // Destructor: Clean up resources used by AudioDAQ
-    ~AudioDAQ();
+    ~AudioDAQ() override;
 
     // Initialize audio devices using settings from an INI file
     void initDevices(const char* filename);
@@ -39,25 +50,75 @@ public:
     // Select a specific audio device by index
     void selectDevice(int choice);
 
+    // Use a simulated source ("sim:sine", "sim:noise", "sim:wav:<path>") instead of a sound card
+    void selectSimulatedDevice(const string& device, SimulatedCapture::Pacing pacing);
+
     // Configure the selected audio device with a specific sample rate
     void configureDevice(unsigned int sampleRate);
 
+    // Set the ALSA period and buffer sizes in frames (0 keeps the driver default) and the frames per captured block
+    void setBufferSizes(snd_pcm_uframes_t periodFrames, snd_pcm_uframes_t bufferFrames, snd_pcm_uframes_t blockFrames);
+
+    // Capture through the mmap'ed DMA buffer instead of snd_pcm_readi
+    void setMmapAccess(bool enabled);
+
+    // Set the number of interleaved channels and the sample encoding for the next configureDevice()
+    void setFormat(unsigned int channels, AudioFormat::Encoding encoding);
+
+    // Capture on a shared engine thread instead of a thread of our own; nullptr restores the own thread
+    void setCaptureEngine(AudioCaptureEngine* engine);
+
     // Start capturing audio data
     void startCapture();
 
     // Stop capturing audio data
     void stopCapture();
 
-    // Retrieve the buffer containing the captured audio data
-    vector<double> getBuffer() const;
+    typedef BlockRing<uint8_t>::ReadLease BlockLease;
+
+    // Borrow the oldest captured block (interleaved frames as captured) without copying; empty if none is ready
+    BlockLease acquireBlock();
 
     // Get the total number of data blocks captured
     int getTimes() const;
 
     // Get the current sample rate of the audio device
-    unsigned int getSampleRate() const;
+    unsigned int getSampleRate() const override;
+
+    // Get the descriptor that becomes readable when a new block is captured
+    int getEventFd() const override;
+
+    // Clear the descriptor and count the blocks captured since the last call
+    uint64_t drainEvents() override;
+
+    // AcquisitionSource interface: initDevices(), startCapture() and stopCapture()
+    bool configure(const char* filename) override;
+    bool start() override;
+    void stop() override;
+
+    // Hand over the oldest unread block, as native integer codes or converted to double per `sampleType`
+    bool readBlock(DataBlock& block) override;
+
+    // One entry per captured channel, in raw codes or full scale for FLOAT_LE
+    vector<ChannelInfo> getChannels() const override;
+
+    // Blocks captured so far and blocks lost because the ring was full
+    uint64_t getBlockCount() const override;
+    uint64_t getDroppedBlocks() const override;
+
+    // Sample-clock error against CLOCK_MONOTONIC_RAW, and stamping blocks from its fit
+    bool getDriftPpm(double& ppm) const override;
+    void setAlignTimestamps(bool align) override;
+
+    // Encoding of the captured samples
+    bool getAudioEncoding(AudioFormat::Encoding& encoding) const override;
+
+    // Set how many captured blocks may wait for the consumer
+    void setRingBlocks(size_t blocks) override;
 
 private:
+    friend class AudioCaptureEngine;
+
     // Structure representing an audio device
     struct AudioDevice {
         int card;                // Card index of the audio device
@@ -69,14 +130,60 @@ private:
     int choice;                                // Index of the selected device
     vector<AudioDevice> devices;          // List of detected audio devices
     string selectedDevice;                // Identifier for the selected device
-    vector<double> buffer;                // Buffer for storing captured audio data
+    BlockRing<uint8_t> ring;                // Preallocated captured blocks, as raw interleaved frames
+    vector<uint8_t> overrunBuffer;         // Capture target when the ring is full
+    size_t ringBlocks;                    // Number of blocks in the ring
     unsigned int sampleRate;                   // Sampling rate in Hz
-    int times;                                 // Number of captured data blocks
+    unsigned int channels;                     // Interleaved channels per frame
+    AudioFormat::Encoding encoding;            // Sample encoding on the wire
+    bool mmapAccess;                      // SND_PCM_ACCESS_MMAP_INTERLEAVED instead of RW_INTERLEAVED
+    snd_pcm_uframes_t periodFrames;       // Requested ALSA period size, 0 for the driver default
+    snd_pcm_uframes_t bufferFrames;       // Requested ALSA buffer size, 0 for the driver default
+    snd_pcm_uframes_t blockFrames;        // Frames per captured block, 0 for one second
+    SampleFormat sampleFormat;                 // Format handed to the consumer
+    atomic<int> times;                         // Number of captured data blocks
     atomic<bool> capturing;               // Flag indicating if capturing is active
+    bool simulated;                       // Capture from `simulator` instead of ALSA
+    SimulatedCapture::Pacing simPacing;   // Pacing of the simulated source
+    SimulatedCapture simulator;           // Signal generator or WAV replay for `device=sim:...`
     thread captureThread;                 // Thread for capturing audio data
+    AudioCaptureEngine* captureEngine;    // Shared capture thread, or nullptr to use captureThread
+    BlockRing<uint8_t>::Slot* pendingSlot; // Ring slot being filled by the engine, nullptr if overrunning
+    uint8_t* pendingTarget;               // Buffer being filled by the engine, nullptr between blocks
+    snd_pcm_uframes_t pendingFrames;      // Frames already in pendingTarget
+    bool hardwareTimestamps;              // snd_pcm_htimestamp reports CLOCK_MONOTONIC_RAW
+    int64_t captureStartNs;               // CLOCK_MONOTONIC_RAW time capture started
+    uint64_t framesCaptured;              // Frames captured since start, dropped blocks included
+    DriftEstimator drift;                 // Compares framesCaptured with driver or read-return times
+    bool alignTimestamps;                 // Stamp blocks from the drift fit instead of per-block readings
+    EventNotifier blockReady;             // Signaled after every captured block
 
     // Internal method for the capture loop
     void captureLoop();
+
+    // Fill `target` with `frames` frames straight from the DMA area; same return contract as snd_pcm_readi.
+    // Without `wait` it returns what is available, or -EAGAIN if nothing is.
+    snd_pcm_sframes_t readMmap(uint8_t* target, snd_pcm_uframes_t frames, bool wait);
+
+    // Commit a finished block to the ring (or count it as dropped) and wake the consumer
+    void finishBlock(BlockRing<uint8_t>::Slot* slot, snd_pcm_uframes_t frames);
+
+    // Acquisition time of the first frame of a block of `frames` frames that was just read;
+    // also feeds the block's end to the drift estimator
+    int64_t blockTimestamp(snd_pcm_uframes_t frames);
+
+    // Restart the stream after an overrun
+    void recoverOverrun();
+
+    // AudioCaptureEngine: number of descriptors to poll, and filling them in
+    unsigned int pollDescriptorCount();
+    void pollDescriptors(struct pollfd* fds, unsigned int count);
+
+    // AudioCaptureEngine: read what is available after poll()
+    void servicePoll(struct pollfd* fds, unsigned int count);
+
+    // Bytes per interleaved frame
+    size_t frameBytes() const;
 };
 
 #endif // AUDIO_DAQ_H
@@ -0,0 +1,150 @@
+#include "AudioFormat.h"
+#include <cstring>
+
+bool AudioFormat::parse(const string& name, Encoding& encoding) {
+    if (name == "S16_LE") {
+        encoding = Encoding::S16;
+    } else if (name == "S24_LE") {
+        encoding = Encoding::S24;
+    } else if (name == "S24_3LE") {
+        encoding = Encoding::S24Packed;
+    } else if (name == "S32_LE") {
+        encoding = Encoding::S32;
+    } else if (name == "FLOAT_LE") {
+        encoding = Encoding::Float;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* AudioFormat::name(Encoding encoding) {
+    switch (encoding) {
+        case Encoding::S16:       return "S16_LE";
+        case Encoding::S24:       return "S24_LE";
+        case Encoding::S24Packed: return "S24_3LE";
+        case Encoding::S32:       return "S32_LE";
+        default:                  return "FLOAT_LE";
+    }
+}
+
+size_t AudioFormat::bytesPerSample(Encoding encoding) {
+    switch (encoding) {
+        case Encoding::S16:       return 2;
+        case Encoding::S24Packed: return 3;
+        default:                  return 4;
+    }
+}
+
+SampleFormat AudioFormat::nativeFormat(Encoding encoding) {
+    switch (encoding) {
+        case Encoding::S16:   return SampleFormat::Int16;
+        case Encoding::Float: return SampleFormat::Float64;
+        default:              return SampleFormat::Int32;
+    }
+}
+
+double AudioFormat::fullScale(Encoding encoding) {
+    switch (encoding) {
+        case Encoding::S16:   return 32767.0;
+        case Encoding::S32:   return 2147483647.0;
+        case Encoding::Float: return 1.0;
+        default:              return 8388607.0;
+    }
+}
+
+template <typename Out>
+void AudioFormat::decodeS16(const uint8_t* in, size_t samples, Out* out) {
+    for (size_t i = 0; i < samples; ++i) {
+        int16_t v;
+        memcpy(&v, in + 2 * i, sizeof(v));
+        out[i] = static_cast<Out>(v);
+    }
+}
+
+// Shift the 24-bit value to the top of the word and back to sign-extend it;
+// S24_LE leaves the padding byte undefined, so it is never trusted.
+template <typename Out>
+void AudioFormat::decodeS24(const uint8_t* in, size_t samples, Out* out) {
+    for (size_t i = 0; i < samples; ++i) {
+        uint32_t v;
+        memcpy(&v, in + 4 * i, sizeof(v));
+        out[i] = static_cast<Out>(static_cast<int32_t>(v << 8) >> 8);
+    }
+}
+
+// Four packed samples fill exactly three 32-bit words; each sample is cut out so its
+// top byte lands in the top of a word, and an arithmetic shift sign-extends it.
+// GCC does not vectorize this loop for baseline x86-64: it only packs the four
+// shifts of a group into one vector (basic-block SLP). A byte-wise loop does vectorize
+// with SSSE3's pshufb, but measured no faster for double output and about 15% faster
+// for int32, both already several GB/s, so it is not worth a CPU-specific build.
+template <typename Out>
+void AudioFormat::decodeS24Packed(const uint8_t* in, size_t samples, Out* out) {
+    const size_t groups = samples / 4;
+    for (size_t g = 0; g < groups; ++g) {
+        uint32_t w0, w1, w2;
+        memcpy(&w0, in + 12 * g, sizeof(w0));
+        memcpy(&w1, in + 12 * g + 4, sizeof(w1));
+        memcpy(&w2, in + 12 * g + 8, sizeof(w2));
+        out[4 * g]     = static_cast<Out>(static_cast<int32_t>(w0 << 8) >> 8);
+        out[4 * g + 1] = static_cast<Out>(static_cast<int32_t>((w0 >> 16) | (w1 << 16)) >> 8);
+        out[4 * g + 2] = static_cast<Out>(static_cast<int32_t>((w1 >> 8) | (w2 << 24)) >> 8);
+        out[4 * g + 3] = static_cast<Out>(static_cast<int32_t>(w2) >> 8);
+    }
+    for (size_t i = groups * 4; i < samples; ++i) {
+        const uint8_t* p = in + 3 * i;
+        uint32_t v = static_cast<uint32_t>(p[0]) << 8 | static_cast<uint32_t>(p[1]) << 16 |
+                     static_cast<uint32_t>(p[2]) << 24;
+        out[i] = static_cast<Out>(static_cast<int32_t>(v) >> 8);
+    }
+}
+
+template <typename Out>
+void AudioFormat::decodeS32(const uint8_t* in, size_t samples, Out* out) {
+    for (size_t i = 0; i < samples; ++i) {
+        int32_t v;
+        memcpy(&v, in + 4 * i, sizeof(v));
+        out[i] = static_cast<Out>(v);
+    }
+}
+
+void AudioFormat::decodeFloat(const uint8_t* in, size_t samples, double* out) {
+    for (size_t i = 0; i < samples; ++i) {
+        float v;
+        memcpy(&v, in + 4 * i, sizeof(v));
+        out[i] = v;
+    }
+}
+
+void AudioFormat::decode(Encoding encoding, const uint8_t* in, size_t samples, SampleFormat format, DataBlock& block) {
+    block.format = format;
+    if (format == SampleFormat::Float64) {
+        block.values.resize(samples);
+        double* out = block.values.data();
+        switch (encoding) {
+            case Encoding::S16:       decodeS16(in, samples, out); break;
+            case Encoding::S24:       decodeS24(in, samples, out); break;
+            case Encoding::S24Packed: decodeS24Packed(in, samples, out); break;
+            case Encoding::S32:       decodeS32(in, samples, out); break;
+            case Encoding::Float:     decodeFloat(in, samples, out); break;
+        }
+    } else if (format == SampleFormat::Int32 && encoding != Encoding::Float) {
+        block.wideCodes.resize(samples);
+        int32_t* out = block.wideCodes.data();
+        switch (encoding) {
+            case Encoding::S16:       decodeS16(in, samples, out); break;
+            case Encoding::S24:       decodeS24(in, samples, out); break;
+            case Encoding::S24Packed: decodeS24Packed(in, samples, out); break;
+            default:                  decodeS32(in, samples, out); break;
+        }
+    } else if (format == SampleFormat::Int16 && encoding == Encoding::S16) {
+        // S16 is already the in-memory layout of int16_t on a little-endian host
+        block.codes.resize(samples);
+        memcpy(block.codes.data(), in, samples * sizeof(int16_t));
+    } else {
+        block.values.clear();
+        block.codes.clear();
+        block.wideCodes.clear();
+    }
+}
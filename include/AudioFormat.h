@@ -0,0 +1,58 @@
+#ifndef AUDIO_FORMAT_H
+#define AUDIO_FORMAT_H
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include "DataBlock.h"
+
+using namespace std;
+
+// AudioFormat decodes interleaved PCM frames, exactly as ALSA delivers them,
+// into a DataBlock. The loops are written without branches or aliasing so the
+// compiler vectorizes them; the Makefile builds this file with -O3. The packed
+// 24-bit decoder is the exception, see decodeS24Packed().
+class AudioFormat {
+public:
+    // Sample encodings AudioDAQ can capture (all little-endian).
+    enum class Encoding {
+        S16,        // SND_PCM_FORMAT_S16_LE
+        S24,        // SND_PCM_FORMAT_S24_LE: 24 bits in the low bytes of a 32-bit container
+        S24Packed,  // SND_PCM_FORMAT_S24_3LE: 24 bits in 3 bytes
+        S32,        // SND_PCM_FORMAT_S32_LE
+        Float       // SND_PCM_FORMAT_FLOAT_LE, full scale is +-1.0
+    };
+
+    // Parses "S16_LE", "S24_LE", "S24_3LE", "S32_LE" or "FLOAT_LE"; returns false for anything else.
+    static bool parse(const string& name, Encoding& encoding);
+
+    // ALSA-style name of the encoding, e.g. "S24_3LE".
+    static const char* name(Encoding encoding);
+
+    // Bytes one sample of one channel occupies in the capture buffer.
+    static size_t bytesPerSample(Encoding encoding);
+
+    // Narrowest DataBlock format that holds the samples without loss.
+    static SampleFormat nativeFormat(Encoding encoding);
+
+    // Largest sample value; the range is [-fullScale - 1, fullScale] for integers and [-1, 1] for Float.
+    static double fullScale(Encoding encoding);
+
+    // Decodes `samples` samples (all channels) from `in` into `block` as `format`.
+    // Integer output narrower than the encoding, or from Float, is not supported and leaves the block empty.
+    static void decode(Encoding encoding, const uint8_t* in, size_t samples, SampleFormat format, DataBlock& block);
+
+private:
+    // Each decoder writes `samples` outputs; `in` holds samples * bytesPerSample() bytes.
+    template <typename Out>
+    static void decodeS16(const uint8_t* in, size_t samples, Out* out);
+    template <typename Out>
+    static void decodeS24(const uint8_t* in, size_t samples, Out* out);
+    template <typename Out>
+    static void decodeS24Packed(const uint8_t* in, size_t samples, Out* out);
+    template <typename Out>
+    static void decodeS32(const uint8_t* in, size_t samples, Out* out);
+    static void decodeFloat(const uint8_t* in, size_t samples, double* out);
+};
+
+#endif // AUDIO_FORMAT_H
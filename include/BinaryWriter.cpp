@@ -0,0 +1,304 @@
+#include "BinaryWriter.h"
+#include <iostream>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include "Timestamp.h"
+
+static const size_t BLOCK_HEADER_SIZE = 32; // "BLK2", count, file sequence, source sequence, timestamp
+
+// Appends a trivially copyable value to a byte vector.
+template <typename T>
+static void appendValue(vector<char>& out, const T& value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+// Appends a length-prefixed string to a byte vector.
+static void appendString(vector<char>& out, const string& text) {
+    uint16_t length = static_cast<uint16_t>(min<size_t>(text.size(), UINT16_MAX));
+    appendValue(out, length);
+    out.insert(out.end(), text.begin(), text.begin() + length);
+}
+
+static size_t sampleSize(BinaryWriter::SampleType type) {
+    switch (type) {
+        case BinaryWriter::SampleType::Float64: return sizeof(double);
+        case BinaryWriter::SampleType::Int16:   return sizeof(int16_t);
+        case BinaryWriter::SampleType::Int32:   return sizeof(int32_t);
+        default:                                return sizeof(float);
+    }
+}
+
+// Constructor: Derives the integer quantization and generates the first filename.
+BinaryWriter::BinaryWriter(const vector<ChannelInfo>& channels, double sampleRate, const string& outputDir,
+                           const string& label, SampleType sampleType, size_t bufferSize)
+    : channels(channels), sampleRate(sampleRate), outputDir(outputDir), label(label),
+      sampleType(sampleType), compression(Compression::None), scale(channels.size(), 1.0), offset(channels.size(), 0.0),
+      native(channels.size(), false), coefficients(channels.size()),
+      blockSequence(0), fileBuffer(bufferSize) {
+    if (sampleType == SampleType::Int16 || sampleType == SampleType::Int32) {
+        // Map [minVal, maxVal] onto the full code range so that value = code * scale + offset.
+        double levels = sampleType == SampleType::Int16 ? 65535.0 : 4294967295.0;
+        double half = sampleType == SampleType::Int16 ? 32768.0 : 2147483648.0;
+        for (size_t i = 0; i < channels.size(); ++i) {
+            double range = channels[i].maxVal - channels[i].minVal;
+            scale[i] = range > 0 ? range / levels : 1.0;
+            offset[i] = channels[i].minVal + half * scale[i];
+            // A range of whole numbers within the code range, e.g. S24 audio counts, is kept as it is
+            // for integer input; float input over the same range is still spread over every code.
+            double low = channels[i].minVal;
+            double high = channels[i].maxVal;
+            native[i] = low == floor(low) && high == floor(high) && low >= -half && high <= half - 1;
+        }
+    }
+    currentFilename = generateFilename(outputDir, label, ".bin");
+}
+
+BinaryWriter::~BinaryWriter() {
+    lock_guard<mutex> lock(fileMutex);
+    fileBuffer.close();
+}
+
+bool BinaryWriter::parseSampleType(const string& text, SampleType& type) {
+    if (text == "float32") {
+        type = SampleType::Float32;
+    } else if (text == "float64") {
+        type = SampleType::Float64;
+    } else if (text == "int16") {
+        type = SampleType::Int16;
+    } else if (text == "int32") {
+        type = SampleType::Int32;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void BinaryWriter::setCompression(Compression mode) {
+    lock_guard<mutex> lock(fileMutex);
+    if (mode == Compression::Rice && sampleType != SampleType::Int16 && sampleType != SampleType::Int32) {
+        cerr << "Rice compression needs an int16 or int32 sample type; storing uncompressed." << endl;
+        mode = Compression::None;
+    }
+    compression = mode;
+}
+
+// The headroom covers the file header and the block headers.
+void BinaryWriter::setFileFrames(uint64_t frames) {
+    lock_guard<mutex> lock(fileMutex);
+    fileBuffer.setPreallocation(frames > 0 ? frames * channels.size() * sampleSize(sampleType) + 64 * 1024 : 0);
+}
+
+void BinaryWriter::setIoMode(BufferedFile::IoMode mode) {
+    lock_guard<mutex> lock(fileMutex);
+    fileBuffer.setIoMode(mode);
+}
+
+bool BinaryWriter::parseCompression(const string& text, Compression& mode) {
+    if (text == "none") {
+        mode = Compression::None;
+    } else if (text == "rice") {
+        mode = Compression::Rice;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Integer codes are copied when they fit the sample type and either carry their own
+// scaling polynomial (raw ADC codes) or already lie in the code range (e.g. S24 audio in int32).
+bool BinaryWriter::passesThrough(size_t channel, size_t inputBits) const {
+    size_t outputBits = sampleType == SampleType::Int16 ? 16 : (sampleType == SampleType::Int32 ? 32 : 0);
+    bool raw = !channels[channel].scaling.empty();
+    return inputBits > 0 && inputBits <= outputBits && (raw || native[channel]);
+}
+
+void BinaryWriter::chooseEncoding(SampleFormat format) {
+    size_t inputBits = format == SampleFormat::Int16 ? 16 : (format == SampleFormat::Int32 ? 32 : 0);
+    for (size_t i = 0; i < channels.size(); ++i) {
+        if (passesThrough(i, inputBits)) {
+            coefficients[i] = channels[i].scaling.empty() ? vector<double>{ 0.0, 1.0 } : channels[i].scaling;
+        } else {
+            coefficients[i] = { offset[i], scale[i] };
+        }
+    }
+}
+
+// Opens the file and writes the header describing every channel.
+// The start time is the first block's acquisition time, in wall-clock and monotonic form.
+bool BinaryWriter::openFile(SampleFormat format, int64_t timestampNs) {
+    if (!fileBuffer.open(currentFilename)) {
+        return false;
+    }
+    chooseEncoding(format);
+
+    int64_t startRaw = timestampNs != 0 ? timestampNs : monotonicRawNs();
+    int64_t startTime = startRaw + realtimeOffsetNs();
+
+    vector<char> header;
+    header.insert(header.end(), "DAQBIN3", "DAQBIN3" + 8);
+    appendValue(header, uint32_t(0)); // Header size, patched below
+    appendValue(header, static_cast<uint32_t>(sampleType));
+    appendValue(header, static_cast<uint32_t>(channels.size()));
+    appendValue(header, sampleRate);
+    appendValue(header, startTime);
+    appendValue(header, startRaw);
+    for (size_t i = 0; i < channels.size(); ++i) {
+        appendString(header, channels[i].name);
+        appendString(header, channels[i].units);
+        appendValue(header, static_cast<uint16_t>(coefficients[i].size()));
+        for (double c : coefficients[i]) {
+            appendValue(header, c);
+        }
+    }
+    uint32_t headerSize = static_cast<uint32_t>(header.size());
+    memcpy(header.data() + 8, &headerSize, sizeof(headerSize));
+
+    fileBuffer.sputn(header.data(), header.size());
+    blockSequence = 0;
+    return true;
+}
+
+template <typename In, typename Out>
+void BinaryWriter::packChannel(const In* samples, size_t samplesPerChannel, int channel, Out* out) const {
+    const size_t numChannels = channels.size();
+    const In* in = samples + channel;
+    if (passesThrough(channel, is_integral<In>::value ? sizeof(In) * 8 : 0)) {
+        // Native codes (raw ADC codes, int16 audio) are copied code for code.
+        for (size_t i = 0; i < samplesPerChannel; ++i) {
+            out[i] = static_cast<Out>(in[i * numChannels]);
+        }
+        return;
+    }
+
+    // Raw codes are scaled here, on the writer thread, rather than on the acquisition thread.
+    const ChannelInfo& info = channels[channel];
+    const double inverse = 1.0 / scale[channel];
+    const double center = offset[channel];
+    for (size_t i = 0; i < samplesPerChannel; ++i) {
+        double value = is_integral<In>::value ? info.toUnits(in[i * numChannels]) : static_cast<double>(in[i * numChannels]);
+        if constexpr (is_integral<Out>::value) {
+            const double low = numeric_limits<Out>::min();
+            const double high = numeric_limits<Out>::max();
+            double code = nearbyint((value - center) * inverse);
+            out[i] = static_cast<Out>(code > high ? high : (code < low ? low : code));
+        } else {
+            out[i] = static_cast<Out>(value);
+        }
+    }
+}
+
+template <typename In>
+void BinaryWriter::packBlock(const In* samples, size_t samplesPerChannel, uint8_t* column) const {
+    const size_t bytesPerSample = sampleSize(sampleType);
+    for (size_t c = 0; c < channels.size(); ++c) {
+        switch (sampleType) {
+            case SampleType::Float32:
+                packChannel(samples, samplesPerChannel, c, reinterpret_cast<float*>(column));
+                break;
+            case SampleType::Float64:
+                packChannel(samples, samplesPerChannel, c, reinterpret_cast<double*>(column));
+                break;
+            case SampleType::Int16:
+                packChannel(samples, samplesPerChannel, c, reinterpret_cast<int16_t*>(column));
+                break;
+            case SampleType::Int32:
+                packChannel(samples, samplesPerChannel, c, reinterpret_cast<int32_t*>(column));
+                break;
+        }
+        column += samplesPerChannel * bytesPerSample;
+    }
+}
+
+// Builds the block header followed by the channel-major payload, or its compressed form.
+// Only reads the configuration, so any thread may encode while another writes.
+void BinaryWriter::encodeBlock(const DataBlock& block, vector<uint8_t>& out) const {
+    out.clear();
+    if (channels.empty()) {
+        return;
+    }
+    const size_t samplesPerChannel = block.size() / channels.size();
+    const size_t payloadBytes = samplesPerChannel * channels.size() * sampleSize(sampleType);
+    const bool compress = compression == Compression::Rice;
+
+    // Compressed blocks are packed into a scratch buffer first and coded into `out` from there
+    static thread_local vector<uint8_t> columns;
+    out.resize(BLOCK_HEADER_SIZE + (compress ? sizeof(uint32_t) : payloadBytes));
+    uint8_t* packed = out.data() + BLOCK_HEADER_SIZE;
+    if (compress) {
+        columns.resize(payloadBytes);
+        packed = columns.data();
+    }
+
+    uint32_t count = static_cast<uint32_t>(samplesPerChannel);
+    uint64_t fileSequence = 0; // Assigned by writeRecord()
+    memcpy(out.data(), compress ? "BLKR" : "BLK2", 4);
+    memcpy(out.data() + 4, &count, sizeof(count));
+    memcpy(out.data() + 8, &fileSequence, sizeof(fileSequence));
+    memcpy(out.data() + 16, &block.sequence, sizeof(block.sequence));
+    memcpy(out.data() + 24, &block.timestampNs, sizeof(block.timestampNs));
+
+    if (block.format == SampleFormat::Int16) {
+        packBlock(block.codes.data(), samplesPerChannel, packed);
+    } else if (block.format == SampleFormat::Int32) {
+        packBlock(block.wideCodes.data(), samplesPerChannel, packed);
+    } else {
+        packBlock(block.values.data(), samplesPerChannel, packed);
+    }
+
+    if (compress) {
+        if (sampleType == SampleType::Int16) {
+            compressColumns(reinterpret_cast<const int16_t*>(packed), samplesPerChannel, out);
+        } else {
+            compressColumns(reinterpret_cast<const int32_t*>(packed), samplesPerChannel, out);
+        }
+    }
+}
+
+// The compressed size follows the "BLKR" header.
+template <typename Code>
+void BinaryWriter::compressColumns(const Code* columns, size_t samplesPerChannel, vector<uint8_t>& out) const {
+    const size_t headerSize = BLOCK_HEADER_SIZE + sizeof(uint32_t);
+    for (size_t c = 0; c < channels.size(); ++c) {
+        RiceCodec::encode(columns + c * samplesPerChannel, samplesPerChannel, out);
+    }
+    uint32_t size = static_cast<uint32_t>(out.size() - headerSize);
+    memcpy(out.data() + BLOCK_HEADER_SIZE, &size, sizeof(size));
+}
+
+// Numbers the encoded block within the current file and appends it, opening the file first if needed.
+void BinaryWriter::writeRecord(vector<uint8_t>& record, SampleFormat format, int64_t timestampNs) {
+    if (record.empty()) {
+        return;
+    }
+    if (!fileBuffer.isOpen() && !openFile(format, timestampNs)) {
+        return;
+    }
+    memcpy(record.data() + 8, &blockSequence, sizeof(blockSequence));
+    fileBuffer.sputn(reinterpret_cast<const char*>(record.data()), record.size());
+    blockSequence++;
+}
+
+void BinaryWriter::addDataBlock(DataBlock&& block) {
+    lock_guard<mutex> lock(fileMutex); // Ensure thread safety
+    encodeBlock(block, payload);
+    writeRecord(payload, block.format, block.timestampNs);
+}
+
+bool BinaryWriter::encodesInParallel() const {
+    return compression != Compression::None;
+}
+
+void BinaryWriter::writeEncodedBlock(vector<uint8_t>& bytes, SampleFormat format, int64_t timestampNs) {
+    lock_guard<mutex> lock(fileMutex); // Ensure thread safety
+    writeRecord(bytes, format, timestampNs);
+}
+
+// Closes the finished file; the next block opens the new one with a fresh header.
+void BinaryWriter::updateFilename() {
+    lock_guard<mutex> lock(fileMutex); // Ensure thread safety
+    fileBuffer.close();
+    currentFilename = generateFilename(outputDir, label, ".bin");
+}
@@ -0,0 +1,136 @@
+#ifndef BINARY_WRITER_H
+#define BINARY_WRITER_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+#include "BufferedFile.h"
+#include "DataWriter.h"
+#include "RiceCodec.h"
+
+using namespace std;
+
+// BinaryWriter stores data blocks in a self-describing little-endian file.
+//
+// File header:
+//   char[8]  magic "DAQBIN3\0"
+//   uint32   header size in bytes (including the magic)
+//   uint32   sample type (0 = float32, 1 = float64, 2 = int16, 3 = int32)
+//   uint32   number of channels
+//   float64  sample rate in Hz
+//   int64    acquisition time of the first sample, nanoseconds since the UNIX epoch
+//   int64    the same instant on CLOCK_MONOTONIC_RAW, the clock of the block timestamps
+//   per channel: uint16 name length, name, uint16 units length, units,
+//                uint16 coefficient count, float64 coefficients c0, c1, ...
+//                (value = c0 + c1 * stored + c2 * stored^2 + ...)
+//
+// Each block:
+//   char[4]  magic "BLK2"
+//   uint32   samples per channel
+//   uint64   block sequence number within the file
+//   uint64   block sequence number of the source (gaps are dropped blocks)
+//   int64    acquisition time of the block's first sample, CLOCK_MONOTONIC_RAW nanoseconds
+//   payload  channel-major samples: all of channel 0, then channel 1, ...
+//
+// With Rice compression (integer sample types only) each block is instead:
+//   char[4]  magic "BLKR"
+//   ...      the same count, sequence numbers and timestamp as "BLK2"
+//   uint32   payload size in bytes
+//   payload  every channel compressed by RiceCodec, one after the other
+class BinaryWriter : public DataWriter {
+public:
+    // Storage type of the samples in the payload.
+    enum class SampleType : uint32_t {
+        Float32 = 0,
+        Float64 = 1,
+        Int16 = 2,  // Raw codes, or quantized over each channel's [minVal, maxVal] range
+        Int32 = 3   // Same as Int16 with 32-bit codes
+    };
+
+    // Constructor: Initializes the writer with channel descriptions, sample rate, output directory and label.
+    BinaryWriter(const vector<ChannelInfo>& channels, double sampleRate, const string& outputDir,
+                 const string& label, SampleType sampleType = SampleType::Float32,
+                 size_t bufferSize = BufferedFile::DEFAULT_BUFFER_SIZE);
+
+    // Destructor: Flushes and closes the current file.
+    ~BinaryWriter() override;
+
+    // Appends one block of interleaved samples to the current file.
+    // Raw integer codes that fit the sample type are stored without conversion and the
+    // channel's scaling polynomial goes into the header; everything else is scaled first.
+    void addDataBlock(DataBlock&& block) override;
+    using DataWriter::addDataBlock;
+
+    // Compressed blocks are worth encoding on a CompressionPool; see DataWriter.
+    bool encodesInParallel() const override;
+    void encodeBlock(const DataBlock& block, vector<uint8_t>& out) const override;
+    void writeEncodedBlock(vector<uint8_t>& bytes, SampleFormat format, int64_t timestampNs) override;
+
+    // Starts a new file when `SaveUnit` is reached.
+    void updateFilename() override;
+
+    // Parses "float32", "float64", "int16" or "int32"; returns false for anything else.
+    static bool parseSampleType(const string& text, SampleType& type);
+
+    // How block payloads are stored.
+    enum class Compression {
+        None,  // Samples as they are
+        Rice   // Lossless RiceCodec compression of integer sample types
+    };
+
+    // Sets the payload compression; float sample types are always stored uncompressed.
+    void setCompression(Compression mode);
+
+    // Parses "none" or "rice"; returns false for anything else.
+    static bool parseCompression(const string& text, Compression& mode);
+
+    // Preallocates each new file for `frames` uncompressed samples per channel; see DataWriter.
+    void setFileFrames(uint64_t frames) override;
+
+    // Sets the I/O mode of the data files; see DataWriter.
+    void setIoMode(BufferedFile::IoMode mode) override;
+
+private:
+    vector<ChannelInfo> channels; // Channel descriptions written into the header
+    double sampleRate;            // Sampling rate in Hz
+    string outputDir;             // Directory where files will be stored
+    string label;                 // Label to include in the filename
+    string currentFilename;       // Current output filename
+    SampleType sampleType;        // Storage type of the payload
+    Compression compression;      // Payload compression
+    vector<double> scale;         // Per-channel quantization step of integer sample types
+    vector<double> offset;        // Per-channel quantization offset of integer sample types
+    vector<bool> native;          // Per-channel: [minVal, maxVal] is a range of codes that fits the sample type
+    vector<vector<double>> coefficients; // Per-channel polynomial written into the header
+    uint64_t blockSequence;       // Blocks written to the current file
+    BufferedFile fileBuffer;      // Persistent file handle and write buffer
+    vector<uint8_t> payload;      // Reusable encoded block, header included
+    mutex fileMutex;              // Mutex for thread safety
+
+    // True if integer codes of `inputBits` bits are stored unchanged for `channel`.
+    bool passesThrough(size_t channel, size_t inputBits) const;
+
+    // Chooses the per-channel header polynomial for blocks of the given format.
+    void chooseEncoding(SampleFormat format);
+
+    // Opens the current file and writes its header; the first block has `format` and `timestampNs`.
+    bool openFile(SampleFormat format, int64_t timestampNs);
+
+    // Converts one channel of an interleaved block into channel-major storage.
+    template <typename In, typename Out>
+    void packChannel(const In* samples, size_t samplesPerChannel, int channel, Out* out) const;
+
+    // Packs every channel of a block into `column`, one channel after the other.
+    template <typename In>
+    void packBlock(const In* samples, size_t samplesPerChannel, uint8_t* column) const;
+
+    // Appends the Rice coding of every packed channel to a "BLKR" record.
+    template <typename Code>
+    void compressColumns(const Code* columns, size_t samplesPerChannel, vector<uint8_t>& out) const;
+
+    // Appends one encoded block to the current file; caller holds fileMutex.
+    void writeRecord(vector<uint8_t>& record, SampleFormat format, int64_t timestampNs);
+};
+
+#endif // BINARY_WRITER_H
@@ -0,0 +1,34 @@
+#include "BlockIndex.h"
+#include "Timestamp.h"
+#include <cinttypes>
+#include <cstdio>
+
+BlockIndex::BlockIndex(size_t bufferSize) : file(bufferSize) {}
+
+bool BlockIndex::open(const string& dataFilename, int64_t startNs) {
+    if (!file.open(dataFilename + ".idx", true)) {
+        return false;
+    }
+    string header = "# clock=CLOCK_MONOTONIC_RAW start_ns=" + to_string(startNs) +
+                    " realtime_offset_ns=" + to_string(realtimeOffsetNs()) + "\nframe,sequence,timestamp_ns\n";
+    file.sputn(header.data(), header.size());
+    return true;
+}
+
+// One short line per block.
+void BlockIndex::add(uint64_t frame, uint64_t sequence, int64_t timestampNs) {
+    if (!file.isOpen()) {
+        return;
+    }
+    char line[72];
+    int length = snprintf(line, sizeof(line), "%" PRIu64 ",%" PRIu64 ",%" PRId64 "\n", frame, sequence, timestampNs);
+    file.sputn(line, length);
+}
+
+void BlockIndex::close() {
+    file.close();
+}
+
+bool BlockIndex::isOpen() const {
+    return file.isOpen();
+}
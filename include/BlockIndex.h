@@ -0,0 +1,39 @@
+#ifndef BLOCK_INDEX_H
+#define BLOCK_INDEX_H
+
+#include <string>
+#include <cstdint>
+#include "BufferedFile.h"
+
+using namespace std;
+
+// BlockIndex writes the "<data file>.idx" sidecar that records when each block of a
+// CSV or WAV file was acquired, since neither format has room for it. Text file:
+//   # clock=CLOCK_MONOTONIC_RAW start_ns=<first block> realtime_offset_ns=<CLOCK_REALTIME - CLOCK_MONOTONIC_RAW>
+//   frame,sequence,timestamp_ns
+//   0,0,<acquisition time of frame 0>
+//   ...
+// `frame` is the first frame of the block within the data file and `sequence` the
+// source's block number, so gaps show where blocks were dropped.
+class BlockIndex {
+public:
+    // Constructor: `bufferSize` 1 writes every line through, e.g. for CSVWriter's Reopen mode.
+    explicit BlockIndex(size_t bufferSize = 64 * 1024);
+
+    // Creates the index for `dataFilename`; `startNs` is the acquisition time of its first block.
+    bool open(const string& dataFilename, int64_t startNs);
+
+    // Appends one block; does nothing if no index is open.
+    void add(uint64_t frame, uint64_t sequence, int64_t timestampNs);
+
+    // Flushes and closes the index.
+    void close();
+
+    // Returns true while an index file is open.
+    bool isOpen() const;
+
+private:
+    BufferedFile file; // Index file and its write buffer
+};
+
+#endif // BLOCK_INDEX_H
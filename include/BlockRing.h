@@ -0,0 +1,152 @@
+#ifndef BLOCK_RING_H
+#define BLOCK_RING_H
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+
+using namespace std;
+
+// BlockRing is a fixed-capacity, lock-free single-producer/single-consumer ring
+// of preallocated sample blocks. The producer fills a slot in place and commits
+// it; the consumer borrows committed slots through a ReadLease without copying.
+// When the ring is full the producer's block is counted as dropped and its
+// sequence number is skipped, so losses are visible instead of silent.
+template <typename T>
+class BlockRing {
+public:
+    static constexpr size_t CACHE_LINE = 64;
+
+    // One preallocated block. Each slot starts on its own cache line.
+    struct alignas(CACHE_LINE) Slot {
+        vector<T> data;       // Sample storage, sized once by reset()
+        size_t count;         // Number of valid samples in data
+        uint64_t sequence;    // Block number assigned by the producer
+        int64_t timestampNs;  // Acquisition time of the first sample, CLOCK_MONOTONIC_RAW nanoseconds
+        int64_t committedNs;  // steady_clock time of commitWrite(), for latency measurements
+    };
+
+    // Move-only handle to a committed slot; the slot is released when it goes out of scope.
+    class ReadLease {
+    public:
+        ReadLease() : ring(nullptr), slot(nullptr) {}
+        ReadLease(BlockRing* ring, const Slot* slot) : ring(ring), slot(slot) {}
+        ReadLease(ReadLease&& other) noexcept : ring(other.ring), slot(other.slot) {
+            other.ring = nullptr;
+            other.slot = nullptr;
+        }
+        ReadLease& operator=(ReadLease&& other) noexcept {
+            if (this != &other) {
+                release();
+                ring = other.ring;
+                slot = other.slot;
+                other.ring = nullptr;
+                other.slot = nullptr;
+            }
+            return *this;
+        }
+        ReadLease(const ReadLease&) = delete;
+        ReadLease& operator=(const ReadLease&) = delete;
+        ~ReadLease() { release(); }
+
+        explicit operator bool() const { return slot != nullptr; }
+        const Slot* operator->() const { return slot; }
+        const Slot& operator*() const { return *slot; }
+
+        // Hands the slot back to the producer early.
+        void release() {
+            if (ring) {
+                ring->releaseRead();
+                ring = nullptr;
+                slot = nullptr;
+            }
+        }
+
+    private:
+        BlockRing* ring;
+        const Slot* slot;
+    };
+
+    BlockRing() : head(0), tail(0), dropped(0), nextSequence(0) {}
+
+    BlockRing(const BlockRing&) = delete;
+    BlockRing& operator=(const BlockRing&) = delete;
+
+    // Allocates `capacity` slots of `blockSize` samples. Not thread-safe: call before the producer starts.
+    void reset(size_t capacity, size_t blockSize) {
+        slots = vector<Slot>(capacity > 0 ? capacity : 1);
+        for (Slot& slot : slots) {
+            slot.data.assign(blockSize, T());
+            slot.count = 0;
+            slot.sequence = 0;
+            slot.timestampNs = 0;
+            slot.committedNs = 0;
+        }
+        head.store(0, memory_order_relaxed);
+        tail.store(0, memory_order_relaxed);
+        dropped.store(0, memory_order_relaxed);
+        nextSequence = 0;
+    }
+
+    // Producer: returns the next free slot to fill, or nullptr if the consumer is behind.
+    Slot* beginWrite() {
+        uint64_t h = head.load(memory_order_relaxed);
+        if (h - tail.load(memory_order_acquire) >= slots.size()) {
+            return nullptr;
+        }
+        return &slots[h % slots.size()];
+    }
+
+    // Producer: publishes the slot returned by beginWrite(); `timestampNs` is the acquisition time.
+    void commitWrite(size_t count, int64_t timestampNs) {
+        uint64_t h = head.load(memory_order_relaxed);
+        Slot& slot = slots[h % slots.size()];
+        slot.count = count;
+        slot.sequence = nextSequence++;
+        slot.timestampNs = timestampNs;
+        slot.committedNs = chrono::duration_cast<chrono::nanoseconds>(
+            chrono::steady_clock::now().time_since_epoch()).count();
+        head.store(h + 1, memory_order_release);
+    }
+
+    // Producer: records a block that had to be discarded because the ring was full.
+    void markDropped() {
+        nextSequence++;
+        dropped.fetch_add(1, memory_order_relaxed);
+    }
+
+    // Consumer: borrows the oldest committed slot, or returns an empty lease.
+    // Only one lease may be held at a time.
+    ReadLease acquireRead() {
+        uint64_t t = tail.load(memory_order_relaxed);
+        if (t == head.load(memory_order_acquire)) {
+            return ReadLease();
+        }
+        return ReadLease(this, &slots[t % slots.size()]);
+    }
+
+    // Number of committed blocks waiting for the consumer.
+    size_t size() const {
+        return static_cast<size_t>(head.load(memory_order_acquire) - tail.load(memory_order_acquire));
+    }
+
+    size_t capacity() const { return slots.size(); }
+
+    // Blocks lost because the ring was full.
+    uint64_t droppedBlocks() const { return dropped.load(memory_order_relaxed); }
+
+private:
+    vector<Slot> slots;                           // Preallocated blocks
+    alignas(CACHE_LINE) atomic<uint64_t> head;    // Next slot to write (producer owned)
+    alignas(CACHE_LINE) atomic<uint64_t> tail;    // Next slot to read (consumer owned)
+    alignas(CACHE_LINE) atomic<uint64_t> dropped; // Blocks lost to overruns
+    uint64_t nextSequence;                        // Producer-side block counter
+
+    void releaseRead() {
+        tail.store(tail.load(memory_order_relaxed) + 1, memory_order_release);
+    }
+};
+
+#endif // BLOCK_RING_H
@@ -0,0 +1,296 @@
+#include "BufferedFile.h"
+#include <iostream>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <new>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Aligned buffers of destroyed BufferedFiles, kept for the next one of the same size,
+// since every recording session creates its writers anew.
+struct AlignedPool {
+    mutex lock;                     // Guards free
+    multimap<size_t, char*> free;   // Unused buffers by size
+
+    ~AlignedPool() {
+        for (auto& entry : free) {
+            std::free(entry.second);
+        }
+    }
+};
+
+static AlignedPool& alignedPool() {
+    static AlignedPool pool;
+    return pool;
+}
+
+static char* acquireBuffer(size_t size) {
+    AlignedPool& pool = alignedPool();
+    {
+        lock_guard<mutex> guard(pool.lock);
+        auto found = pool.free.find(size);
+        if (found != pool.free.end()) {
+            char* buffer = found->second;
+            pool.free.erase(found);
+            return buffer;
+        }
+    }
+    void* memory = nullptr;
+    if (posix_memalign(&memory, BufferedFile::ALIGNMENT, size) != 0) {
+        throw bad_alloc();
+    }
+    return static_cast<char*>(memory);
+}
+
+static void releaseBuffer(char* buffer, size_t size) {
+    AlignedPool& pool = alignedPool();
+    lock_guard<mutex> guard(pool.lock);
+    pool.free.emplace(size, buffer);
+}
+
+// Constructor: Takes the buffer and points the put area at it.
+BufferedFile::BufferedFile(size_t bufferSize)
+    : fd(-1), buffer(nullptr), bufferSize(max<size_t>(bufferSize, 1)),
+      ioMode(IoMode::Buffered), direct(false) {
+    buffer = acquireBuffer(this->bufferSize);
+    setp(buffer, buffer + this->bufferSize);
+}
+
+BufferedFile::~BufferedFile() {
+    close();
+    releaseBuffer(buffer, bufferSize);
+}
+
+// Opens a file for appending; the descriptor is kept until close() or the next open().
+// O_APPEND makes pwrite() append on Linux, so truncating opens leave it off.
+// A prepared file is only used for a new name, so appending to an existing file works as before;
+// checking the name is a lookup, while creating the link is left to the preparer's thread.
+bool BufferedFile::open(const string& filename, bool truncate) {
+    close();
+    if (preparer) {
+        if (truncate || access(filename.c_str(), F_OK) != 0) {
+            fd = preparer->take(filename, truncate);
+        }
+        preparer->prepare(SegmentPreparer::directoryOf(filename), truncate);
+    }
+    if (fd < 0) {
+        int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (truncate ? O_TRUNC : O_APPEND);
+        fd = ::open(filename.c_str(), flags, 0644);
+        if (fd < 0) {
+            cerr << "Failed to open file: " << filename << " (" << strerror(errno) << ")" << endl;
+            return false;
+        }
+    }
+    if (ioMode == IoMode::Direct) {
+        enableDirect();
+    }
+    return true;
+}
+
+// Flushes remaining data and releases the descriptor.
+void BufferedFile::close() {
+    if (fd < 0) {
+        return;
+    }
+    flush();
+    if (preparer) {
+        preparer->retire(fd);
+    } else {
+        ::close(fd);
+    }
+    fd = -1;
+    direct = false;
+}
+
+void BufferedFile::setPreallocation(uint64_t bytes) {
+    preparer = bytes > 0 ? make_unique<SegmentPreparer>(bytes) : nullptr;
+}
+
+void BufferedFile::setIoMode(IoMode mode) {
+    ioMode = mode;
+}
+
+bool BufferedFile::parseIoMode(const string& text, IoMode& mode) {
+    if (text == "buffered") {
+        mode = IoMode::Buffered;
+    } else if (text == "direct") {
+        mode = IoMode::Direct;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool BufferedFile::isOpen() const {
+    return fd >= 0;
+}
+
+// Writes the filled part of the buffer; anything a write error left unwritten stays in it.
+bool BufferedFile::flush() {
+    if (direct) {
+        if (!flushBlocks()) {
+            return false;
+        }
+        if (pptr() == pbase()) {
+            return true;
+        }
+        disableDirect();
+    }
+    size_t pending = pptr() - pbase();
+    if (pending == 0) {
+        return true;
+    }
+    size_t written = writeAll(buffer, pending);
+    consume(written);
+    return written == pending;
+}
+
+// Appending to an existing file that does not end on a block boundary stays buffered.
+// A file system without O_DIRECT is reported once and then written through the page cache.
+void BufferedFile::enableDirect() {
+    off_t end = lseek(fd, 0, SEEK_END);
+    if (end < 0 || end % static_cast<off_t>(ALIGNMENT) != 0) {
+        return;
+    }
+    int flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_DIRECT) != 0) {
+        cerr << "Direct I/O is not supported here (" << strerror(errno) << "), using the page cache." << endl;
+        ioMode = IoMode::Buffered;
+        return;
+    }
+    if (bufferSize % ALIGNMENT != 0) {
+        releaseBuffer(buffer, bufferSize);
+        bufferSize = (bufferSize + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        buffer = acquireBuffer(bufferSize);
+        setp(buffer, buffer + bufferSize);
+    }
+    direct = true;
+}
+
+void BufferedFile::disableDirect() {
+    int flags = fcntl(fd, F_GETFL);
+    if (flags >= 0) {
+        fcntl(fd, F_SETFL, flags & ~O_DIRECT);
+    }
+    direct = false;
+}
+
+// The buffer starts on a block boundary and so does the file, so every write stays aligned.
+bool BufferedFile::flushBlocks() {
+    size_t pending = pptr() - pbase();
+    size_t blocks = pending - pending % ALIGNMENT;
+    size_t written = blocks == 0 ? 0 : writeAll(buffer, blocks);
+    consume(written);
+    return written == blocks;
+}
+
+void BufferedFile::consume(size_t written) {
+    size_t pending = pptr() - pbase();
+    memmove(buffer, buffer + written, pending - written);
+    setp(buffer, buffer + bufferSize);
+    pbump(static_cast<int>(pending - written));
+}
+
+// Patches already written bytes in place.
+bool BufferedFile::writeAt(uint64_t offset, const void* data, size_t size) {
+    if (fd < 0 || !flush()) {
+        return false;
+    }
+    if (direct) {
+        disableDirect();
+    }
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t written = ::pwrite(fd, bytes, size, static_cast<off_t>(offset));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            cerr << "Write error: " << strerror(errno) << endl;
+            return false;
+        }
+        bytes += written;
+        offset += written;
+        size -= written;
+    }
+    return true;
+}
+
+// Called when the buffer is full: flush it and store the pending character.
+BufferedFile::int_type BufferedFile::overflow(int_type ch) {
+    if (!(direct ? flushBlocks() : flush())) {
+        return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+// Copies into the buffer; writes larger than the buffer bypass it entirely, except
+// with O_DIRECT, which only writes from the aligned buffer.
+streamsize BufferedFile::xsputn(const char* s, streamsize n) {
+    streamsize space = epptr() - pptr();
+    if (n <= space) {
+        memcpy(pptr(), s, n);
+        pbump(static_cast<int>(n));
+        return n;
+    }
+    if (direct) {
+        streamsize copied = 0;
+        while (copied < n) {
+            if (pptr() == epptr() && !flushBlocks()) {
+                return copied;
+            }
+            streamsize chunk = min<streamsize>(n - copied, epptr() - pptr());
+            memcpy(pptr(), s + copied, chunk);
+            pbump(static_cast<int>(chunk));
+            copied += chunk;
+        }
+        return n;
+    }
+    if (!flush()) {
+        return 0;
+    }
+    if (static_cast<size_t>(n) >= bufferSize) {
+        return static_cast<streamsize>(writeAll(s, n));
+    }
+    memcpy(pptr(), s, n);
+    pbump(static_cast<int>(n));
+    return n;
+}
+
+int BufferedFile::sync() {
+    return flush() ? 0 : -1;
+}
+
+// Loops until every byte is written, since write(2) may return early. A device whose
+// blocks are larger than ALIGNMENT rejects direct writes, which are then retried buffered.
+size_t BufferedFile::writeAll(const char* data, size_t size) {
+    if (fd < 0) {
+        return 0;
+    }
+    const size_t total = size;
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EINVAL && direct) {
+                disableDirect();
+                continue;
+            }
+            cerr << "Write error: " << strerror(errno) << endl;
+            return total - size;
+        }
+        data += written;
+        size -= written;
+    }
+    return total;
+}
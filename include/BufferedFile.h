@@ -0,0 +1,100 @@
+#ifndef BUFFERED_FILE_H
+#define BUFFERED_FILE_H
+
+#include <streambuf>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "SegmentPreparer.h"
+
+using namespace std;
+
+// BufferedFile is a stream buffer over a POSIX file descriptor that stays open
+// across data blocks and only issues a write(2) when its user-space buffer fills.
+// With preallocation, each new file is created and allocated ahead of time by a
+// SegmentPreparer, so opening the next file does not stall the writer.
+// With direct I/O, whole 4 KiB blocks bypass the page cache (O_DIRECT) and only
+// the unaligned tail of a file goes through it when the file is flushed or closed.
+class BufferedFile : public streambuf {
+public:
+    static constexpr size_t DEFAULT_BUFFER_SIZE = 1 << 20; // 1 MiB
+    static constexpr size_t ALIGNMENT = 4096;              // Direct I/O block and buffer alignment
+
+    // How data reaches the disk.
+    enum class IoMode {
+        Buffered,  // Through the page cache
+        Direct     // O_DIRECT from the aligned buffer, falling back to Buffered where unsupported
+    };
+
+    // Constructor: Takes an aligned write buffer from a shared pool. A size of 1 writes every
+    // write through; direct I/O rounds the buffer up to whole ALIGNMENT blocks.
+    explicit BufferedFile(size_t bufferSize = DEFAULT_BUFFER_SIZE);
+
+    // Destructor: Flushes pending data, closes the file and returns the buffer to the pool.
+    ~BufferedFile() override;
+
+    BufferedFile(const BufferedFile&) = delete;
+    BufferedFile& operator=(const BufferedFile&) = delete;
+
+    // Opens (or creates) a file in append mode, closing any file already open.
+    // With `truncate`, an existing file is emptied instead and writeAt() may patch earlier bytes.
+    bool open(const string& filename, bool truncate = false);
+
+    // Flushes the buffer and closes the file.
+    void close();
+
+    // Creates each following file in the background with `bytes` already allocated,
+    // and trims the spare allocation when it is closed. 0 turns this off.
+    void setPreallocation(uint64_t bytes);
+
+    // Sets the I/O mode of files opened from now on.
+    void setIoMode(IoMode mode);
+
+    // Parses "buffered" or "direct"; returns false for anything else.
+    static bool parseIoMode(const string& text, IoMode& mode);
+
+    // Returns true while a file descriptor is held.
+    bool isOpen() const;
+
+    // Writes buffered data to the file descriptor. A direct file's unaligned tail is written
+    // through the page cache, and the rest of that file too. On a write error the unwritten
+    // bytes stay buffered for the next flush.
+    bool flush();
+
+    // Flushes, then overwrites bytes at an absolute offset (e.g. a header) without moving
+    // the write position. Requires a file opened with `truncate`.
+    bool writeAt(uint64_t offset, const void* data, size_t size);
+
+protected:
+    int_type overflow(int_type ch) override;
+    streamsize xsputn(const char* s, streamsize n) override;
+    int sync() override;
+
+private:
+    int fd;                  // File descriptor of the current file, -1 if closed
+    char* buffer;            // User-space write buffer, ALIGNMENT-aligned
+    size_t bufferSize;       // Size of buffer, a multiple of ALIGNMENT while direct
+    IoMode ioMode;           // Mode of files opened from now on
+    bool direct;             // The current file is written with O_DIRECT
+    unique_ptr<SegmentPreparer> preparer; // Prepares the next file, null without preallocation
+
+    // Switches the newly opened file to O_DIRECT if it ends on a block boundary,
+    // first growing the buffer to whole blocks.
+    void enableDirect();
+
+    // Switches the current file back to the page cache.
+    void disableDirect();
+
+    // Writes the whole blocks in the buffer and moves the rest to its start.
+    bool flushBlocks();
+
+    // Drops the first `written` buffered bytes, moving the rest to the start of the buffer.
+    void consume(size_t written);
+
+    // Writes a range to the file descriptor, retrying on partial writes. Returns the bytes
+    // written, fewer than `size` only after an error.
+    size_t writeAll(const char* data, size_t size);
+};
+
+#endif // BUFFERED_FILE_H
@@ -0,0 +1,88 @@
+#include "CSVFormatter.h"
+#include <charconv>
+#include <algorithm>
+
+// Worst case for a shortest round-trip double, e.g. "-2.2250738585072014e-308".
+static const size_t MAX_SHORTEST_CHARS = 32;
+
+// Constructor: Allocates a row buffer sized for the shortest format.
+CSVFormatter::CSVFormatter(int numChannels)
+    : numChannels(numChannels), precision(numChannels, SHORTEST) {
+    reserveRow();
+}
+
+void CSVFormatter::setPrecision(int digits) {
+    fill(precision.begin(), precision.end(), digits);
+    reserveRow();
+}
+
+void CSVFormatter::setPrecision(const vector<int>& digits) {
+    if (digits.empty()) {
+        return;
+    }
+    for (int i = 0; i < numChannels; ++i) {
+        precision[i] = digits[min(static_cast<size_t>(i), digits.size() - 1)];
+    }
+    reserveRow();
+}
+
+// Each value gets room for its digits plus a separator; the '\n' replaces the last comma.
+void CSVFormatter::reserveRow() {
+    size_t size = 0;
+    for (int digits : precision) {
+        size += MAX_SHORTEST_CHARS + (digits > 0 ? digits : 0) + 1;
+    }
+    rowBuffer.resize(max<size_t>(size, 1));
+}
+
+size_t CSVFormatter::formatRow(const double* row) {
+    char* out = rowBuffer.data();
+    for (int j = 0; j < numChannels; ++j) {
+        char* end = out + MAX_SHORTEST_CHARS + (precision[j] > 0 ? precision[j] : 0);
+        to_chars_result result;
+        if (precision[j] == SHORTEST) {
+            result = to_chars(out, end, row[j]);
+        } else {
+            result = to_chars(out, end, row[j], chars_format::fixed, precision[j]);
+            if (result.ec != errc()) {
+                // Magnitudes too large for fixed notation fall back to the shortest form.
+                result = to_chars(out, end, row[j]);
+            }
+        }
+        out = result.ptr;
+        *out++ = ',';
+    }
+    if (numChannels > 0) {
+        out[-1] = '\n';
+    } else {
+        *out++ = '\n';
+    }
+    return out - rowBuffer.data();
+}
+
+size_t CSVFormatter::formatRow(const int16_t* row) {
+    return formatIntegers(row);
+}
+
+size_t CSVFormatter::formatRow(const int32_t* row) {
+    return formatIntegers(row);
+}
+
+template <typename T>
+size_t CSVFormatter::formatIntegers(const T* row) {
+    char* out = rowBuffer.data();
+    for (int j = 0; j < numChannels; ++j) {
+        out = to_chars(out, out + MAX_SHORTEST_CHARS, row[j]).ptr;
+        *out++ = ',';
+    }
+    if (numChannels > 0) {
+        out[-1] = '\n';
+    } else {
+        *out++ = '\n';
+    }
+    return out - rowBuffer.data();
+}
+
+const char* CSVFormatter::data() const {
+    return rowBuffer.data();
+}
@@ -0,0 +1,52 @@
+#ifndef CSV_FORMATTER_H
+#define CSV_FORMATTER_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+// CSVFormatter turns one row of samples into comma-separated text using
+// std::to_chars, which is locale-independent and much faster than operator<<.
+class CSVFormatter {
+public:
+    static constexpr int SHORTEST = -1; // Shortest representation that round-trips exactly
+
+    // Constructor: All channels default to the shortest round-trip format.
+    explicit CSVFormatter(int numChannels);
+
+    // Sets the number of digits after the decimal point for every channel.
+    void setPrecision(int digits);
+
+    // Sets per-channel precision; the last entry repeats for any remaining channels.
+    void setPrecision(const vector<int>& digits);
+
+    // Formats one interleaved row (numChannels values) terminated by '\n'.
+    // Returns the row length; the text stays valid in data() until the next call.
+    size_t formatRow(const double* row);
+
+    // Formats one row of 16-bit integers; precision does not apply.
+    size_t formatRow(const int16_t* row);
+
+    // Formats one row of 32-bit integers; precision does not apply.
+    size_t formatRow(const int32_t* row);
+
+    // Pointer to the most recently formatted row.
+    const char* data() const;
+
+private:
+    int numChannels;         // Number of values per row
+    vector<int> precision;   // Digits after the decimal point per channel, or SHORTEST
+    vector<char> rowBuffer;  // Reusable row buffer
+
+    // Resizes the row buffer so a full row always fits.
+    void reserveRow();
+
+    // Shared implementation of the integer overloads.
+    template <typename T>
+    size_t formatIntegers(const T* row);
+};
+
+#endif // CSV_FORMATTER_H
@@ -1,53 +1,141 @@
 #include "CSVWriter.h"
 
 // Constructor: Initializes the CSVWriter and generates the first CSV filename.
-CSVWriter::CSVWriter(int numChannels, const string& outputDir, const string& label)
-    : numChannels(numChannels), outputDir(outputDir), label(label) {
-    currentFilename = generateFilename(); // Generate initial filename
+CSVWriter::CSVWriter(int numChannels, const string& outputDir, const string& label, Mode mode, size_t bufferSize)
+    : numChannels(numChannels), outputDir(outputDir), label(label), mode(mode),
+      fileBuffer(mode == Mode::Persistent ? bufferSize : 1), fileStream(&fileBuffer),
+      formatter(numChannels), index(mode == Mode::Persistent ? 64 * 1024 : 1), fileFrames(0) {
+    currentFilename = generateFilename(outputDir, label, ".csv"); // Generate initial filename
+}
+
+// Destructor: Flushes buffered rows of the last file.
+CSVWriter::~CSVWriter() {
+    lock_guard<mutex> lock(fileMutex);
+    fileBuffer.close();
+    index.close();
 }
 
 // Writes incoming data to the file immediately.
-void CSVWriter::addDataBlock(vector<double>&& dataBlock) {
+void CSVWriter::addDataBlock(DataBlock&& block) {
     lock_guard<mutex> lock(fileMutex); // Ensure thread safety
+
+    if (mode == Mode::Persistent) {
+        // The file is opened on the first block and kept until updateFilename().
+        if (!fileBuffer.isOpen() && !fileBuffer.open(currentFilename)) {
+            return;
+        }
+        indexBlock(block);
+        writeRows(fileStream, block);
+        return;
+    }
+
     ofstream file(currentFilename, ios::app); // Open file in append mode
     if (!file.is_open()) {
         cerr << "Failed to open file: " << currentFilename << endl;
         return;
     }
+    indexBlock(block);
+    writeRows(file, block);
+    file.close();
+}
 
-    // Write data to CSV file in rows, with values separated by commas.
-    for (size_t i = 0; i < dataBlock.size(); i += numChannels) {
-        for (int j = 0; j < numChannels; ++j) {
-            file << dataBlock[i + j];
-            if (j < numChannels - 1) {
-                file << ",";
-            }
-        }
-        file << "\n";
+// One index line per block, so the per-sample cost stays zero.
+void CSVWriter::indexBlock(const DataBlock& block) {
+    if (numChannels <= 0) {
+        return;
     }
-    file.close();
+    if (!index.isOpen()) {
+        index.open(currentFilename, block.timestampNs);
+    }
+    index.add(fileFrames, block.sequence, block.timestampNs);
+    fileFrames += block.size() / numChannels;
 }
 
 // Updates the filename when a `SaveUnit` is reached.
 void CSVWriter::updateFilename() {
     lock_guard<mutex> lock(fileMutex); // Ensure thread safety
-    currentFilename = generateFilename();
+    fileBuffer.close(); // Flush the finished file; the next block opens the new one
+    index.close();
+    fileFrames = 0;
+    currentFilename = generateFilename(outputDir, label, ".csv");
+}
+
+// Sets the output precision of each channel.
+void CSVWriter::setPrecision(const vector<int>& digits) {
+    lock_guard<mutex> lock(fileMutex);
+    formatter.setPrecision(digits);
+}
+
+// Sized for values of up to 15 characters plus the separator; the spare space is trimmed on close.
+void CSVWriter::setFileFrames(uint64_t frames) {
+    lock_guard<mutex> lock(fileMutex);
+    if (mode == Mode::Persistent) {
+        fileBuffer.setPreallocation(frames * numChannels * 16);
+    }
 }
 
-// Generates a new CSV filename based on the current timestamp.
-string CSVWriter::generateFilename() {
-    auto now = chrono::system_clock::now();
-    time_t now_time = chrono::system_clock::to_time_t(now);
-    tm local_time;
+void CSVWriter::setIoMode(BufferedFile::IoMode mode) {
+    lock_guard<mutex> lock(fileMutex);
+    if (this->mode == Mode::Persistent) {
+        fileBuffer.setIoMode(mode);
+    }
+}
 
-#ifdef _WIN32
-    localtime_s(&local_time, &now_time); // Windows-specific function
-#else
-    localtime_r(&now_time, &local_time); // POSIX function
-#endif
+// Keeps the channel scaling only if at least one channel delivers raw codes.
+void CSVWriter::setScaling(const vector<ChannelInfo>& channels) {
+    lock_guard<mutex> lock(fileMutex);
+    scaling.clear();
+    for (const ChannelInfo& channel : channels) {
+        if (!channel.scaling.empty()) {
+            scaling = channels;
+            break;
+        }
+    }
+}
 
-    char buffer[64];
-    strftime(buffer, sizeof(buffer), "%Y%m%d%H%M%S", &local_time); // Format timestamp
+// Integer blocks use the integer formatter unless they carry raw codes that need scaling.
+void CSVWriter::writeRows(ostream& out, const DataBlock& block) {
+    if (block.format == SampleFormat::Int16) {
+        if (scaling.empty()) {
+            writeRows(out, block.codes);
+        } else {
+            writeScaledRows(out, block.codes);
+        }
+    } else if (block.format == SampleFormat::Int32) {
+        if (scaling.empty()) {
+            writeRows(out, block.wideCodes);
+        } else {
+            writeScaledRows(out, block.wideCodes);
+        }
+    } else {
+        writeRows(out, block.values);
+    }
+}
 
-    return outputDir + "/" + buffer + "_" + label + ".csv"; // Construct filename
+// Write data to CSV file in rows, with values separated by commas.
+template <typename T>
+void CSVWriter::writeRows(ostream& out, const vector<T>& samples) {
+    if (numChannels <= 0) {
+        return;
+    }
+    for (size_t i = 0; i + numChannels <= samples.size(); i += numChannels) {
+        size_t length = formatter.formatRow(&samples[i]);
+        out.write(formatter.data(), length);
+    }
+}
+
+// Scales the raw codes of a block just before formatting.
+template <typename T>
+void CSVWriter::writeScaledRows(ostream& out, const vector<T>& samples) {
+    if (numChannels <= 0 || scaling.size() != static_cast<size_t>(numChannels)) {
+        writeRows(out, samples);
+        return;
+    }
+    scaled.resize(samples.size());
+    for (size_t i = 0; i + numChannels <= samples.size(); i += numChannels) {
+        for (int j = 0; j < numChannels; ++j) {
+            scaled[i + j] = scaling[j].toUnits(samples[i + j]);
+        }
+    }
+    writeRows(out, scaled);
 }
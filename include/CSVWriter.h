@@ -7,30 +7,77 @@
 #include <vector>
 #include <mutex>
 #include <chrono>
+#include "BufferedFile.h"
+#include "CSVFormatter.h"
+#include "DataWriter.h"
+#include "BlockIndex.h"
 
 using namespace std;
 
 // CSVWriter class handles writing data to CSV files in a thread-safe manner.
-class CSVWriter {
+// Block acquisition times go into a "<file>.csv.idx" sidecar (see BlockIndex).
+class CSVWriter : public DataWriter {
 public:
+    // How the output file is handled between data blocks.
+    enum class Mode {
+        Reopen,     // Open, append and close the file for every block
+        Persistent  // Keep the file open with a large write buffer until updateFilename()
+    };
+
     // Constructor: Initializes CSVWriter with number of channels, output directory, and label.
-    CSVWriter(int numChannels, const string& outputDir, const string& label);
+    CSVWriter(int numChannels, const string& outputDir, const string& label,
+              Mode mode = Mode::Persistent, size_t bufferSize = BufferedFile::DEFAULT_BUFFER_SIZE);
+
+    // Destructor: Flushes and closes the current file.
+    ~CSVWriter() override;
     
     // Writes incoming data immediately to the current CSV file.
-    void addDataBlock(vector<double>&& dataBlock);
+    void addDataBlock(DataBlock&& block) override;
+    using DataWriter::addDataBlock;
     
     // Updates the filename when `SaveUnit` is reached.
-    void updateFilename();
+    void updateFilename() override;
+
+    // Sets per-channel digits after the decimal point (CSVFormatter::SHORTEST for round-trip).
+    void setPrecision(const vector<int>& digits);
+
+    // Converts raw integer blocks to engineering units with each channel's scaling polynomial.
+    // Channels without scaling, e.g. audio, keep writing their integer codes.
+    void setScaling(const vector<ChannelInfo>& channels);
+
+    // Preallocates each new file for `frames` rows; see DataWriter. Reopen mode ignores it.
+    void setFileFrames(uint64_t frames) override;
+
+    // Sets the I/O mode of the data files; see DataWriter. Reopen mode ignores it.
+    void setIoMode(BufferedFile::IoMode mode) override;
 
 private:
     int numChannels;         // Number of channels in the data
     string outputDir;        // Directory where CSV files will be stored
     string label;            // Label to include in the filename
     string currentFilename;  // Current CSV filename
+    Mode mode;               // File handling mode
+    BufferedFile fileBuffer; // Persistent file handle and write buffer
+    ostream fileStream;      // Output stream over fileBuffer
+    CSVFormatter formatter;  // Reusable row formatter
+    vector<ChannelInfo> scaling; // Channels whose raw codes are scaled on output; empty if none
+    vector<double> scaled;   // Reusable buffer for scaled raw blocks
+    BlockIndex index;        // Acquisition time of every block in the current file
+    uint64_t fileFrames;     // Rows written to the current file
     mutex fileMutex;         // Mutex for thread safety
 
-    // Generates a new filename based on the current timestamp.
-    string generateFilename();
+    // Formats a data block as comma-separated rows.
+    void writeRows(ostream& out, const DataBlock& block);
+
+    // Adds the block to the index of the current file, opening the index on the first block.
+    void indexBlock(const DataBlock& block);
+
+    template <typename T>
+    void writeRows(ostream& out, const vector<T>& samples);
+
+    // Writes raw codes in engineering units.
+    template <typename T>
+    void writeScaledRows(ostream& out, const vector<T>& samples);
 };
 
-#endif // CSV_WRITER_H
\ No newline at end of file
+#endif // CSV_WRITER_H
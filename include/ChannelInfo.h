@@ -0,0 +1,30 @@
+#ifndef CHANNEL_INFO_H
+#define CHANNEL_INFO_H
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Describes one acquired channel for self-describing output formats.
+struct ChannelInfo {
+    string name;             // Channel name, e.g. the DAQmxChannel section name
+    string units;            // Engineering units of the values, e.g. "g" or "V"
+    double minVal;           // Lower limit of the expected range
+    double maxVal;           // Upper limit of the expected range
+    vector<double> scaling;  // Polynomial c0, c1, ... from raw codes to units; empty if samples are already scaled
+
+    // Converts a raw code to engineering units (value = c0 + c1*code + c2*code^2 + ...).
+    double toUnits(double code) const {
+        if (scaling.empty()) {
+            return code;
+        }
+        double value = 0.0;
+        for (size_t i = scaling.size(); i-- > 0;) {
+            value = value * code + scaling[i];
+        }
+        return value;
+    }
+};
+
+#endif // CHANNEL_INFO_H
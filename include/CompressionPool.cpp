@@ -0,0 +1,63 @@
+#include "CompressionPool.h"
+#include <algorithm>
+
+CompressionPool::CompressionPool(size_t threads, size_t budgetBytes)
+    : budget(budgetBytes), used(0), stopping(false) {
+    for (size_t i = 0; i < max<size_t>(threads, 1); ++i) {
+        workers.emplace_back(&CompressionPool::run, this);
+    }
+}
+
+CompressionPool::~CompressionPool() {
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    work.notify_all();
+    for (thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void CompressionPool::reserve(size_t bytes) {
+    unique_lock<mutex> guard(lock);
+    space.wait(guard, [&] { return used == 0 || used + bytes <= budget; });
+    used += bytes;
+}
+
+void CompressionPool::release(size_t bytes) {
+    {
+        lock_guard<mutex> guard(lock);
+        used -= min(bytes, used);
+    }
+    space.notify_all();
+}
+
+void CompressionPool::submit(function<void()> task) {
+    {
+        lock_guard<mutex> guard(lock);
+        tasks.push_back(move(task));
+    }
+    work.notify_one();
+}
+
+size_t CompressionPool::threadCount() const {
+    return workers.size();
+}
+
+// Tasks left at shutdown still run, so every reserved byte is released.
+void CompressionPool::run() {
+    while (true) {
+        function<void()> task;
+        {
+            unique_lock<mutex> guard(lock);
+            work.wait(guard, [&] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) {
+                return;
+            }
+            task = move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef COMPRESSION_POOL_H
+#define COMPRESSION_POOL_H
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <cstddef>
+
+using namespace std;
+
+// CompressionPool is a fixed set of worker threads shared by every stream's
+// ParallelEncoder, plus the memory budget that bounds how many bytes of blocks may be
+// in flight across all of them. A block reserves its share before it is queued and
+// releases it once it has been written, so producers wait instead of piling up.
+class CompressionPool {
+public:
+    // Constructor: Starts `threads` workers (at least one); `budgetBytes` bounds the blocks in flight.
+    CompressionPool(size_t threads, size_t budgetBytes);
+
+    // Destructor: Runs the tasks still queued, then stops the workers.
+    ~CompressionPool();
+
+    CompressionPool(const CompressionPool&) = delete;
+    CompressionPool& operator=(const CompressionPool&) = delete;
+
+    // Takes `bytes` of the budget, waiting while it is used up. A single request larger
+    // than the whole budget is granted once nothing else is in flight.
+    void reserve(size_t bytes);
+
+    // Returns `bytes` taken by reserve().
+    void release(size_t bytes);
+
+    // Queues a task for the next free worker.
+    void submit(function<void()> task);
+
+    // Number of worker threads.
+    size_t threadCount() const;
+
+private:
+    vector<thread> workers;           // Worker threads
+    deque<function<void()>> tasks;    // Queued tasks, oldest first
+    size_t budget;                    // Bytes that may be in flight
+    size_t used;                      // Bytes reserved and not yet released
+    bool stopping;                    // Set by the destructor
+    mutex lock;                       // Guards tasks, used and stopping
+    condition_variable work;          // Signaled when a task is queued
+    condition_variable space;         // Signaled when budget is released
+
+    // Worker body.
+    void run();
+};
+
+#endif // COMPRESSION_POOL_H
@@ -0,0 +1,434 @@
+// DAQmxSim implements the part of the NI-DAQmx C API that NiDAQHandler uses, so the
+// program, the pipeline and the benchmarks run without a chassis or libnidaqmx.so.
+// Build with `make SIM=1` to link this file instead of the driver; NiDAQHandler and
+// API/NiDAQ.ini are used unchanged.
+//
+// Every channel produces a deterministic waveform centered in its [min, max] range:
+// sample n of channel c always has the same value, however the reads are split.
+// Environment variables select the signal and the pacing:
+//   DAQMX_SIM_WAVEFORM  sine (default), noise or impulse (decaying ring every 0.5 s)
+//   DAQMX_SIM_PACING    realtime (default): samples appear at SampClk.Rate and an
+//                       input buffer overflow fails like the driver does;
+//                       fast: every read returns immediately
+//   DAQMX_SIM_RAW_BITS  ADC resolution for raw reads, 16 or 24 (default 24)
+#include "NIDAQmx.h"
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+
+enum class Waveform { Sine, Noise, Impulse };
+
+// One simulated analog input channel.
+struct SimChannel {
+    string physicalChannel;  // e.g. "cDAQ1Mod1/ai0"
+    double minVal;           // Range in engineering units
+    double maxVal;
+    double unitsPerVolt;     // Sensor conversion, e.g. 1 g/V for a 1000 mV/g accelerometer
+};
+
+// One simulated task: channels, timing and the read position.
+struct SimTask {
+    vector<SimChannel> channels;
+    double rate = 1000.0;                  // SampClk.Rate
+    uint64_t inputBuffer = 0;              // Samples per channel the driver buffer holds
+    bool running = false;
+    chrono::steady_clock::time_point start;// Time of the first sample
+    uint64_t readPosition = 0;             // Next sample per channel to be read
+
+    // EveryNSamples event
+    DAQmxEveryNSamplesEventCallbackPtr callback = nullptr;
+    void* callbackData = nullptr;
+    uInt32 callbackSamples = 0;
+    thread eventThread;
+    mutex eventMutex;
+    condition_variable eventWake;
+    bool stopping = false;
+};
+
+mutex errorMutex;
+string lastError;
+
+// Records the message returned by DAQmxGetExtendedErrorInfo and passes the code through.
+int32 fail(int32 code, const string& message) {
+    lock_guard<mutex> lock(errorMutex);
+    lastError = "DAQmxSim: " + message;
+    return code;
+}
+
+const char* env(const char* name, const char* fallback) {
+    const char* value = getenv(name);
+    return value && *value ? value : fallback;
+}
+
+Waveform waveform() {
+    string name = env("DAQMX_SIM_WAVEFORM", "sine");
+    if (name == "noise") {
+        return Waveform::Noise;
+    }
+    return name == "impulse" ? Waveform::Impulse : Waveform::Sine;
+}
+
+bool realtime() {
+    return string(env("DAQMX_SIM_PACING", "realtime")) != "fast";
+}
+
+int rawBits() {
+    return atoi(env("DAQMX_SIM_RAW_BITS", "24")) <= 16 ? 16 : 24;
+}
+
+// Counter-based hash, so noise depends only on (channel, sample).
+uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// Value of sample `frame` of channel `index` in engineering units.
+double sampleValue(const SimTask& task, size_t index, uint64_t frame, Waveform shape) {
+    const SimChannel& channel = task.channels[index];
+    const double center = 0.5 * (channel.maxVal + channel.minVal);
+    const double amplitude = 0.25 * (channel.maxVal - channel.minVal);
+    const double t = frame / task.rate;
+    const double pi = 3.14159265358979323846;
+
+    switch (shape) {
+        case Waveform::Noise: {
+            double uniform = (splitmix64(frame * 64 + index) >> 11) * (1.0 / 9007199254740992.0);
+            return center + amplitude * (2.0 * uniform - 1.0);
+        }
+        case Waveform::Impulse: {
+            // An accelerometer hit: a ring that decays within a few tens of milliseconds
+            double since = fmod(t + 0.05 * index, 0.5);
+            double ring = min(200.0 * (index + 1), task.rate / 8.0);
+            return center + amplitude * exp(-since / 0.02) * sin(2.0 * pi * ring * since);
+        }
+        default:
+            return center + amplitude * sin(2.0 * pi * 10.0 * (index + 1) * t);
+    }
+}
+
+// Full-scale input of the simulated ADC in volts.
+double fullScaleVolts(const SimChannel& channel) {
+    double volts = max(fabs(channel.minVal), fabs(channel.maxVal)) / channel.unitsPerVolt;
+    return volts > 0 ? volts : 1.0;
+}
+
+SimTask* lookup(TaskHandle handle) {
+    return static_cast<SimTask*>(handle);
+}
+
+int32 addChannel(TaskHandle handle, const char physicalChannel[], float64 minVal, float64 maxVal, double unitsPerVolt) {
+    SimTask* task = lookup(handle);
+    if (!task) {
+        return fail(DAQmxErrorInvalidTask, "invalid task");
+    }
+    task->channels.push_back({ physicalChannel, minVal, maxVal, unitsPerVolt > 0 ? unitsPerVolt : 1.0 });
+    return 0;
+}
+
+const SimChannel* findChannel(const SimTask* task, const char channel[]) {
+    for (const SimChannel& candidate : task->channels) {
+        if (candidate.physicalChannel == channel) {
+            return &candidate;
+        }
+    }
+    return nullptr;
+}
+
+// Waits until `count` samples per channel past the read position exist and claims them.
+// Returns the first claimed sample, or a negative DAQmx error.
+int64_t claimSamples(SimTask* task, int32& count, float64 timeout, uInt32 arraySizeInSamps) {
+    if (!task || !task->running) {
+        return fail(DAQmxErrorInvalidTask, "task is not running");
+    }
+    const size_t numChannels = max<size_t>(task->channels.size(), 1);
+    const bool paced = realtime();
+
+    if (count < 0) {
+        // DAQmx_Val_Auto: everything available that fits, at least one sample
+        uint64_t available = arraySizeInSamps / numChannels;
+        if (paced) {
+            double elapsed = chrono::duration<double>(chrono::steady_clock::now() - task->start).count();
+            uint64_t acquired = static_cast<uint64_t>(elapsed * task->rate);
+            available = min<uint64_t>(available, acquired > task->readPosition ? acquired - task->readPosition : 1);
+        }
+        count = static_cast<int32>(max<uint64_t>(available, 1));
+    }
+    if (static_cast<uint64_t>(count) * numChannels > arraySizeInSamps) {
+        return fail(DAQmxErrorReadBufferTooSmall, "read array is smaller than the requested samples");
+    }
+
+    if (paced) {
+        auto ready = task->start + chrono::duration_cast<chrono::steady_clock::duration>(
+            chrono::duration<double>((task->readPosition + count) / task->rate));
+        auto now = chrono::steady_clock::now();
+        if (ready - now > chrono::duration<double>(timeout) && timeout >= 0) {
+            this_thread::sleep_for(chrono::duration<double>(timeout));
+            return fail(DAQmxErrorSamplesNotYetAvailable, "timed out waiting for samples");
+        }
+        this_thread::sleep_until(ready);
+
+        // Unread samples beyond the input buffer have been overwritten
+        double elapsed = chrono::duration<double>(chrono::steady_clock::now() - task->start).count();
+        uint64_t acquired = static_cast<uint64_t>(elapsed * task->rate);
+        if (acquired > task->readPosition + task->inputBuffer) {
+            return fail(DAQmxErrorSamplesNoLongerAvailable, "input buffer overflow: the reader fell behind");
+        }
+    }
+
+    int64_t first = static_cast<int64_t>(task->readPosition);
+    task->readPosition += count;
+    return first;
+}
+
+// Fills `out` with `count` samples per channel starting at `first`, converted by `convert`.
+template <typename T, typename Convert>
+void fillSamples(const SimTask* task, uint64_t first, int32 count, bool32 fillMode, T* out, Convert convert) {
+    const size_t numChannels = task->channels.size();
+    const Waveform shape = waveform();
+    for (int32 i = 0; i < count; ++i) {
+        for (size_t c = 0; c < numChannels; ++c) {
+            size_t position = fillMode == DAQmx_Val_GroupByChannel ? c * count + i : i * numChannels + c;
+            out[position] = convert(c, sampleValue(*task, c, first + i, shape));
+        }
+    }
+}
+
+// Quantizes a value in engineering units to an ADC code of the simulated resolution.
+template <typename T>
+T toCode(const SimChannel& channel, double value) {
+    const double levels = ldexp(1.0, rawBits() - 1);
+    double code = nearbyint(value / channel.unitsPerVolt / fullScaleVolts(channel) * levels);
+    code = min(max(code, -levels), levels - 1);
+    return static_cast<T>(code);
+}
+
+// Raises EveryNSamples events at the acquisition rate until the task stops.
+void eventLoop(SimTask* task, TaskHandle handle) {
+    uint64_t acquired = 0;
+    unique_lock<mutex> lock(task->eventMutex);
+    while (!task->stopping) {
+        acquired += task->callbackSamples;
+        if (realtime()) {
+            auto due = task->start + chrono::duration_cast<chrono::steady_clock::duration>(
+                chrono::duration<double>(acquired / task->rate));
+            if (task->eventWake.wait_until(lock, due, [task] { return task->stopping; })) {
+                break;
+            }
+        }
+        lock.unlock();
+        task->callback(handle, DAQmx_Val_Acquired_Into_Buffer, task->callbackSamples, task->callbackData);
+        lock.lock();
+    }
+}
+
+} // namespace
+
+int32 __CFUNC DAQmxCreateTask(const char taskName[], TaskHandle* taskHandle) {
+    (void)taskName;
+    *taskHandle = new SimTask();
+    return 0;
+}
+
+int32 __CFUNC DAQmxCreateAIVoltageChan(TaskHandle taskHandle, const char physicalChannel[], const char nameToAssignToChannel[],
+                                       int32 terminalConfig, float64 minVal, float64 maxVal, int32 units, const char customScaleName[]) {
+    (void)nameToAssignToChannel; (void)terminalConfig; (void)units; (void)customScaleName;
+    return addChannel(taskHandle, physicalChannel, minVal, maxVal, 1.0);
+}
+
+int32 __CFUNC DAQmxCreateAICurrentChan(TaskHandle taskHandle, const char physicalChannel[], const char nameToAssignToChannel[],
+                                       int32 terminalConfig, float64 minVal, float64 maxVal, int32 units, int32 shuntResistorLoc,
+                                       float64 extShuntResistorVal, const char customScaleName[]) {
+    (void)nameToAssignToChannel; (void)terminalConfig; (void)units; (void)shuntResistorLoc; (void)customScaleName;
+    return addChannel(taskHandle, physicalChannel, minVal, maxVal, extShuntResistorVal > 0 ? 1.0 / extShuntResistorVal : 1.0);
+}
+
+int32 __CFUNC DAQmxCreateAIAccelChan(TaskHandle taskHandle, const char physicalChannel[], const char nameToAssignToChannel[],
+                                     int32 terminalConfig, float64 minVal, float64 maxVal, int32 units, float64 sensitivity,
+                                     int32 sensitivityUnits, int32 currentExcitSource, float64 currentExcitVal, const char customScaleName[]) {
+    (void)nameToAssignToChannel; (void)terminalConfig; (void)units; (void)sensitivityUnits;
+    (void)currentExcitSource; (void)currentExcitVal; (void)customScaleName;
+    return addChannel(taskHandle, physicalChannel, minVal, maxVal, sensitivity > 0 ? 1000.0 / sensitivity : 1.0);
+}
+
+int32 __CFUNC DAQmxCfgSampClkTiming(TaskHandle taskHandle, const char source[], float64 rate, int32 activeEdge,
+                                    int32 sampleMode, uInt64 sampsPerChan) {
+    (void)source; (void)activeEdge; (void)sampleMode;
+    SimTask* task = lookup(taskHandle);
+    if (!task) {
+        return fail(DAQmxErrorInvalidTask, "invalid task");
+    }
+    if (rate <= 0) {
+        return fail(DAQmxErrorInvalidAttributeValue, "sample rate must be positive");
+    }
+    task->rate = rate;
+    // Like the driver, continuous tasks get at least one second of buffer
+    task->inputBuffer = max<uint64_t>(sampsPerChan, static_cast<uint64_t>(rate));
+    return 0;
+}
+
+int32 __CFUNC DAQmxCfgInputBuffer(TaskHandle taskHandle, uInt32 numSampsPerChan) {
+    SimTask* task = lookup(taskHandle);
+    if (!task) {
+        return fail(DAQmxErrorInvalidTask, "invalid task");
+    }
+    task->inputBuffer = numSampsPerChan;
+    return 0;
+}
+
+int32 __CFUNC DAQmxGetAIRawSampSize(TaskHandle taskHandle, const char channel[], uInt32* data) {
+    SimTask* task = lookup(taskHandle);
+    if (!task || !findChannel(task, channel)) {
+        return fail(DAQmxErrorAttributeNotSupportedInTaskContext, string("unknown channel ") + channel);
+    }
+    *data = rawBits() <= 16 ? 16 : 32;
+    return 0;
+}
+
+// Raw codes scale linearly to volts: volts = code * fullScale / 2^(bits - 1).
+int32 __CFUNC DAQmxGetAIDevScalingCoeff(TaskHandle taskHandle, const char channel[], float64* data, uInt32 arraySizeInElements) {
+    SimTask* task = lookup(taskHandle);
+    const SimChannel* found = task ? findChannel(task, channel) : nullptr;
+    if (!found) {
+        return fail(DAQmxErrorAttributeNotSupportedInTaskContext, string("unknown channel ") + channel);
+    }
+    const float64 coefficients[4] = { 0.0, fullScaleVolts(*found) / ldexp(1.0, rawBits() - 1), 0.0, 0.0 };
+    if (data == nullptr || arraySizeInElements == 0) {
+        return 4;
+    }
+    memcpy(data, coefficients, min<uInt32>(arraySizeInElements, 4) * sizeof(float64));
+    return 0;
+}
+
+int32 __CFUNC DAQmxRegisterEveryNSamplesEvent(TaskHandle task, int32 everyNsamplesEventType, uInt32 nSamples, uInt32 options,
+                                              DAQmxEveryNSamplesEventCallbackPtr callbackFunction, void* callbackData) {
+    (void)everyNsamplesEventType; (void)options;
+    SimTask* simTask = lookup(task);
+    if (!simTask) {
+        return fail(DAQmxErrorInvalidTask, "invalid task");
+    }
+    if (simTask->callback && callbackFunction) {
+        return fail(DAQmxErrorEveryNSampsEventAlreadyRegistered, "EveryNSamples event already registered");
+    }
+    simTask->callback = callbackFunction;
+    simTask->callbackData = callbackData;
+    simTask->callbackSamples = nSamples > 0 ? nSamples : 1;
+    return 0;
+}
+
+int32 __CFUNC DAQmxStartTask(TaskHandle taskHandle) {
+    SimTask* task = lookup(taskHandle);
+    if (!task) {
+        return fail(DAQmxErrorInvalidTask, "invalid task");
+    }
+    if (task->channels.empty()) {
+        return fail(DAQmxErrorInvalidTask, "task has no channels");
+    }
+    task->readPosition = 0;
+    task->start = chrono::steady_clock::now();
+    task->running = true;
+    if (task->callback) {
+        task->stopping = false;
+        task->eventThread = thread(eventLoop, task, taskHandle);
+    }
+    return 0;
+}
+
+int32 __CFUNC DAQmxStopTask(TaskHandle taskHandle) {
+    SimTask* task = lookup(taskHandle);
+    if (!task) {
+        return fail(DAQmxErrorInvalidTask, "invalid task");
+    }
+    {
+        lock_guard<mutex> lock(task->eventMutex);
+        task->stopping = true;
+    }
+    task->eventWake.notify_all();
+    if (task->eventThread.joinable() && task->eventThread.get_id() != this_thread::get_id()) {
+        task->eventThread.join();
+    }
+    task->running = false;
+    return 0;
+}
+
+int32 __CFUNC DAQmxClearTask(TaskHandle taskHandle) {
+    SimTask* task = lookup(taskHandle);
+    if (!task) {
+        return fail(DAQmxErrorInvalidTask, "invalid task");
+    }
+    DAQmxStopTask(taskHandle);
+    delete task;
+    return 0;
+}
+
+int32 __CFUNC DAQmxReadAnalogF64(TaskHandle taskHandle, int32 numSampsPerChan, float64 timeout, bool32 fillMode,
+                                 float64 readArray[], uInt32 arraySizeInSamps, int32* sampsPerChanRead, bool32* reserved) {
+    (void)reserved;
+    SimTask* task = lookup(taskHandle);
+    int64_t first = claimSamples(task, numSampsPerChan, timeout, arraySizeInSamps);
+    if (first < 0) {
+        *sampsPerChanRead = 0;
+        return static_cast<int32>(first);
+    }
+    fillSamples(task, first, numSampsPerChan, fillMode, readArray, [](size_t, double value) { return value; });
+    *sampsPerChanRead = numSampsPerChan;
+    return 0;
+}
+
+int32 __CFUNC DAQmxReadBinaryI16(TaskHandle taskHandle, int32 numSampsPerChan, float64 timeout, bool32 fillMode,
+                                 int16 readArray[], uInt32 arraySizeInSamps, int32* sampsPerChanRead, bool32* reserved) {
+    (void)reserved;
+    if (rawBits() > 16) {
+        *sampsPerChanRead = 0;
+        return fail(DAQmxErrorReadBufferTooSmall, "raw samples are wider than 16 bits");
+    }
+    SimTask* task = lookup(taskHandle);
+    int64_t first = claimSamples(task, numSampsPerChan, timeout, arraySizeInSamps);
+    if (first < 0) {
+        *sampsPerChanRead = 0;
+        return static_cast<int32>(first);
+    }
+    fillSamples(task, first, numSampsPerChan, fillMode, readArray,
+                [task](size_t c, double value) { return toCode<int16>(task->channels[c], value); });
+    *sampsPerChanRead = numSampsPerChan;
+    return 0;
+}
+
+int32 __CFUNC DAQmxReadBinaryI32(TaskHandle taskHandle, int32 numSampsPerChan, float64 timeout, bool32 fillMode,
+                                 int32 readArray[], uInt32 arraySizeInSamps, int32* sampsPerChanRead, bool32* reserved) {
+    (void)reserved;
+    SimTask* task = lookup(taskHandle);
+    int64_t first = claimSamples(task, numSampsPerChan, timeout, arraySizeInSamps);
+    if (first < 0) {
+        *sampsPerChanRead = 0;
+        return static_cast<int32>(first);
+    }
+    fillSamples(task, first, numSampsPerChan, fillMode, readArray,
+                [task](size_t c, double value) { return toCode<int32>(task->channels[c], value); });
+    *sampsPerChanRead = numSampsPerChan;
+    return 0;
+}
+
+int32 __CFUNC DAQmxGetExtendedErrorInfo(char errorString[], uInt32 bufferSize) {
+    lock_guard<mutex> lock(errorMutex);
+    if (bufferSize == 0) {
+        return static_cast<int32>(lastError.size() + 1);
+    }
+    size_t length = min<size_t>(lastError.size(), bufferSize - 1);
+    memcpy(errorString, lastError.data(), length);
+    errorString[length] = '\0';
+    return 0;
+}
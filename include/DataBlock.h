@@ -0,0 +1,38 @@
+#ifndef DATA_BLOCK_H
+#define DATA_BLOCK_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// Storage type of the samples in a DataBlock.
+enum class SampleFormat {
+    Float64,  // Engineering units, e.g. scaled NI-DAQmx readings
+    Int16,    // Native 16-bit codes, e.g. S16_LE audio or raw 16-bit ADC codes
+    Int32     // Native 32-bit codes, e.g. raw codes of a 24-bit ADC
+};
+
+// One block of interleaved samples travelling from a source to a writer.
+// Only the vector matching `format` is used, so the others stay empty.
+struct DataBlock {
+    SampleFormat format = SampleFormat::Float64;
+    vector<double> values;      // Float64 samples
+    vector<int16_t> codes;      // Int16 samples
+    vector<int32_t> wideCodes;  // Int32 samples
+    uint64_t sequence = 0;      // Block number assigned by the source, counting dropped blocks
+    int64_t timestampNs = 0;    // Acquisition time of the first sample, CLOCK_MONOTONIC_RAW nanoseconds
+    int64_t committedNs = 0;    // steady_clock time at which the source committed the block
+
+    // Number of samples (all channels) in the block.
+    size_t size() const {
+        switch (format) {
+            case SampleFormat::Int16: return codes.size();
+            case SampleFormat::Int32: return wideCodes.size();
+            default:                  return values.size();
+        }
+    }
+};
+
+#endif // DATA_BLOCK_H
@@ -0,0 +1,37 @@
+#include "DataWriter.h"
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+
+// Wraps plain scaled values into a DataBlock.
+void DataWriter::addDataBlock(vector<double>&& dataBlock) {
+    DataBlock block;
+    block.format = SampleFormat::Float64;
+    block.values = move(dataBlock);
+    addDataBlock(move(block));
+}
+
+// Generates a new filename based on the current timestamp. Files can be shorter than a
+// second (small SaveUnit, faster-than-real-time replay), so a name already on disk
+// gets a counter instead of being appended to.
+string DataWriter::generateFilename(const string& outputDir, const string& label, const string& extension) {
+    auto now = chrono::system_clock::now();
+    time_t now_time = chrono::system_clock::to_time_t(now);
+    tm local_time;
+
+#ifdef _WIN32
+    localtime_s(&local_time, &now_time); // Windows-specific function
+#else
+    localtime_r(&now_time, &local_time); // POSIX function
+#endif
+
+    char buffer[64];
+    strftime(buffer, sizeof(buffer), "%Y%m%d%H%M%S", &local_time); // Format timestamp
+
+    string base = outputDir + "/" + buffer + "_" + label; // Construct filename
+    string filename = base + extension;
+    for (int copy = 2; filesystem::exists(filename); ++copy) {
+        filename = base + "_" + to_string(copy) + extension;
+    }
+    return filename;
+}
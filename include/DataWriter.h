@@ -0,0 +1,53 @@
+#ifndef DATA_WRITER_H
+#define DATA_WRITER_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "ChannelInfo.h"
+#include "DataBlock.h"
+#include "BufferedFile.h"
+
+using namespace std;
+
+// DataWriter is the common interface of all file sinks (CSV, binary, ...).
+class DataWriter {
+public:
+    virtual ~DataWriter() = default;
+
+    // Appends one block of interleaved samples to the current file.
+    virtual void addDataBlock(DataBlock&& block) = 0;
+
+    // Appends a block of Float64 samples.
+    void addDataBlock(vector<double>&& dataBlock);
+
+    // Starts a new file when `SaveUnit` is reached.
+    virtual void updateFilename() = 0;
+
+    // Writers whose per-block work (e.g. compression) is worth spreading over several
+    // cores return true and split addDataBlock() into the two calls below, so that
+    // ParallelEncoder can run encodeBlock() on a CompressionPool.
+    virtual bool encodesInParallel() const { return false; }
+
+    // Tells the writer each file will hold about `frames` samples per channel, so it can
+    // prepare the next file ahead of time. 0, the default, prepares nothing.
+    virtual void setFileFrames(uint64_t frames) { (void)frames; }
+
+    // Sets how data files are written from the next file on (see BufferedFile::IoMode).
+    virtual void setIoMode(BufferedFile::IoMode mode) { (void)mode; }
+
+    // Turns a block into the bytes that writeEncodedBlock() appends; called from any thread.
+    virtual void encodeBlock(const DataBlock& block, vector<uint8_t>& out) const { (void)block; out.clear(); }
+
+    // Appends a block encoded by encodeBlock(), in the original block order.
+    // `format` and `timestampNs` are those of the block, for the file header.
+    virtual void writeEncodedBlock(vector<uint8_t>& bytes, SampleFormat format, int64_t timestampNs) {
+        (void)bytes; (void)format; (void)timestampNs;
+    }
+
+protected:
+    // Builds "<outputDir>/<YYYYMMDDHHMMSS>_<label><extension>" from the current time.
+    static string generateFilename(const string& outputDir, const string& label, const string& extension);
+};
+
+#endif // DATA_WRITER_H
@@ -0,0 +1,105 @@
+#include "DriftEstimator.h"
+#include <cmath>
+#include <limits>
+
+DriftEstimator::DriftEstimator(unsigned int sampleRate)
+    : sampleRate(sampleRate), published(numeric_limits<double>::quiet_NaN()) {
+    reset();
+}
+
+void DriftEstimator::setSampleRate(unsigned int rate) {
+    sampleRate = rate;
+    reset();
+}
+
+void DriftEstimator::reset() {
+    hasOrigin = false;
+    originFrame = 0;
+    originNs = 0;
+    windowEnd = 0;
+    windowHasMin = false;
+    windowMinX = 0;
+    windowMinY = 0;
+    windows = 0;
+    weight = 0;
+    meanX = 0;
+    meanY = 0;
+    sxx = 0;
+    sxy = 0;
+    published = numeric_limits<double>::quiet_NaN();
+}
+
+// x is nominal seconds since the origin, y how many nanoseconds later than that schedule
+// the frames were complete. A device that samples slow falls further behind: y grows.
+void DriftEstimator::addObservation(uint64_t frames, int64_t observedNs) {
+    if (sampleRate == 0) {
+        return;
+    }
+    if (!hasOrigin) {
+        hasOrigin = true;
+        originFrame = frames;
+        originNs = observedNs;
+        windowEnd = frames + sampleRate;
+    }
+    if (frames < originFrame) {
+        return;
+    }
+    if (frames >= windowEnd) {
+        fitWindow();
+        windowEnd += sampleRate * ((frames - windowEnd) / sampleRate + 1);
+    }
+
+    double x = static_cast<double>(frames - originFrame) / sampleRate;
+    double y = static_cast<double>(observedNs - originNs) - x * 1e9;
+    if (!windowHasMin || y < windowMinY) {
+        windowHasMin = true;
+        windowMinX = x;
+        windowMinY = y;
+    }
+}
+
+// Incremental weighted least squares; the older windows lose FORGET of their weight first.
+void DriftEstimator::fitWindow() {
+    if (!windowHasMin) {
+        return;
+    }
+    weight *= 1.0 - FORGET;
+    sxx *= 1.0 - FORGET;
+    sxy *= 1.0 - FORGET;
+
+    weight += 1.0;
+    double dx = windowMinX - meanX;
+    meanX += dx / weight;
+    double dy = windowMinY - meanY;
+    meanY += dy / weight;
+    sxx += dx * (windowMinX - meanX);
+    sxy += dx * (windowMinY - meanY);
+    windowHasMin = false;
+
+    if (++windows >= MIN_WINDOWS) {
+        // Real seconds per nominal second is 1 + slope / 1e9, so the true rate is nominal / that
+        published = (1.0 / (1.0 + slope() / 1e9) - 1.0) * 1e6;
+    }
+}
+
+double DriftEstimator::slope() const {
+    return sxx > 0 ? sxy / sxx : 0.0;
+}
+
+bool DriftEstimator::ready() const {
+    return windows >= MIN_WINDOWS;
+}
+
+bool DriftEstimator::ppm(double& value) const {
+    double current = published;
+    if (std::isnan(current)) {
+        return false;
+    }
+    value = current;
+    return true;
+}
+
+int64_t DriftEstimator::alignedNs(uint64_t frame) const {
+    double x = (static_cast<double>(frame) - static_cast<double>(originFrame)) / sampleRate;
+    return originNs + llround(x * 1e9 + meanY + slope() * (x - meanX));
+}
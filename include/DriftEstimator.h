@@ -0,0 +1,75 @@
+#ifndef DRIFT_ESTIMATOR_H
+#define DRIFT_ESTIMATOR_H
+
+#include <cstdint>
+#include <atomic>
+
+using namespace std;
+
+// DriftEstimator measures how far a device's sample clock runs from its nominal rate
+// against CLOCK_MONOTONIC_RAW, the clock every source stamps its blocks with.
+// Each block contributes one observation: "this many frames were complete at this
+// time". The lateness of an observation over the nominal schedule is the clock
+// error plus scheduling latency; latency only ever adds, so the earliest observation
+// of every second is kept and a line is fitted through those. The slope of the line
+// is the drift. Older seconds fade out so slow crystal warm-up is followed.
+//
+// Observations and aligned times come from the acquisition thread; ppm() may be
+// read from any thread.
+class DriftEstimator {
+public:
+    // Constructor: `sampleRate` is the nominal rate in Hz.
+    explicit DriftEstimator(unsigned int sampleRate = 0);
+
+    // Sets the nominal rate and forgets everything.
+    void setSampleRate(unsigned int rate);
+
+    // Forgets everything, e.g. after the frame count skipped over lost samples.
+    // The next observation becomes the origin.
+    void reset();
+
+    // Records that the first `frames` frames were complete at `observedNs`.
+    void addObservation(uint64_t frames, int64_t observedNs);
+
+    // True once enough seconds have been fitted for ppm() and alignedNs() to be meaningful.
+    bool ready() const;
+
+    // Rate error in parts per million: positive when the device samples faster than nominal.
+    // Returns false while not ready().
+    bool ppm(double& value) const;
+
+    // Fitted CLOCK_MONOTONIC_RAW time of frame `frame`; only meaningful when ready().
+    int64_t alignedNs(uint64_t frame) const;
+
+private:
+    static const int MIN_WINDOWS = 5;           // Fitted seconds before ready()
+    static constexpr double FORGET = 1.0 / 600; // Weight lost per fitted second (~10 minute memory)
+
+    unsigned int sampleRate;  // Nominal rate in Hz
+    bool hasOrigin;           // An observation has been made since reset()
+    uint64_t originFrame;     // Frame count of the first observation
+    int64_t originNs;         // Time of the first observation
+
+    // Current one-second window; its earliest observation is fitted when it ends
+    uint64_t windowEnd;       // Frame count that closes the window
+    bool windowHasMin;        // windowMin* are set
+    double windowMinX;        // Nominal seconds since the origin of the earliest observation
+    double windowMinY;        // Its lateness over the nominal schedule in nanoseconds
+
+    // Exponentially weighted least squares of lateness over nominal time
+    int windows;              // Windows fitted since reset()
+    double weight;            // Sum of weights
+    double meanX;             // Weighted mean of x
+    double meanY;             // Weighted mean of y
+    double sxx;               // Weighted sum of squared x deviations
+    double sxy;               // Weighted sum of x-y co-deviations
+    atomic<double> published; // ppm of the latest fit, NaN while not ready
+
+    // Adds the earliest observation of the window that just ended to the fit.
+    void fitWindow();
+
+    // Nanoseconds of lateness gained per nominal second, i.e. the fitted slope.
+    double slope() const;
+};
+
+#endif // DRIFT_ESTIMATOR_H
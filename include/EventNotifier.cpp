@@ -0,0 +1,42 @@
+#include "EventNotifier.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace std;
+
+EventNotifier::EventNotifier()
+    : eventFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+    if (eventFd < 0) {
+        cerr << "Failed to create eventfd: " << strerror(errno) << endl;
+    }
+}
+
+EventNotifier::~EventNotifier() {
+    if (eventFd >= 0) {
+        close(eventFd);
+    }
+}
+
+// Adds one to the eventfd counter, waking any poll() on it.
+void EventNotifier::notify() {
+    uint64_t one = 1;
+    if (eventFd >= 0 && write(eventFd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        cerr << "Failed to signal eventfd: " << strerror(errno) << endl;
+    }
+}
+
+// Reads and resets the counter; returns 0 if nothing was pending.
+uint64_t EventNotifier::drain() {
+    uint64_t count = 0;
+    if (eventFd < 0 || read(eventFd, &count, sizeof(count)) < 0) {
+        return 0;
+    }
+    return count;
+}
+
+int EventNotifier::fd() const {
+    return eventFd;
+}
@@ -0,0 +1,32 @@
+#ifndef EVENT_NOTIFIER_H
+#define EVENT_NOTIFIER_H
+
+#include <cstdint>
+
+// EventNotifier wraps a Linux eventfd so a producer thread can wake a consumer
+// that is blocked in poll()/epoll_wait() together with other descriptors.
+class EventNotifier {
+public:
+    // Constructor: Creates a non-blocking eventfd.
+    EventNotifier();
+
+    // Destructor: Closes the eventfd.
+    ~EventNotifier();
+
+    EventNotifier(const EventNotifier&) = delete;
+    EventNotifier& operator=(const EventNotifier&) = delete;
+
+    // Signals the consumer; the descriptor becomes readable.
+    void notify();
+
+    // Clears pending notifications and returns how many were coalesced.
+    uint64_t drain();
+
+    // Descriptor to wait on with POLLIN.
+    int fd() const;
+
+private:
+    int eventFd; // eventfd descriptor, -1 if creation failed
+};
+
+#endif // EVENT_NOTIFIER_H
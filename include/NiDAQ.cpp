@@ -30,7 +30,8 @@ vector<string> NiDAQfilterSections(const map<string, map<string, string>>& ini_d
 
 // Implementation of NiDAQHandler class
 NiDAQHandler::NiDAQHandler()
-    : taskHandle(0), error(0), tmpDataBuffer(0), dataBuffer(0), bufferSize(0), sampleRate(0), numChannels(0), running(false), read(0), readtimes(0) {
+    : taskHandle(0), error(0), readMode(ReadMode::Scaled), acquisitionMode(AcquisitionMode::Thread), ringBlocks(8),
+      blockSamples(0), bufferSize(0), sampleRate(0), numChannels(0), running(false), read(0), startTimeNs(0), samplesAcquired(0), alignTimestamps(false), readtimes(0) {
     memset(errBuff, 0, sizeof(errBuff));
 }
 
@@ -38,6 +39,11 @@ NiDAQHandler::~NiDAQHandler() {
     stopAndClearTask();
 }
 
+// Set how many blocks the ring holds before new blocks are dropped
+void NiDAQHandler::setRingBlocks(size_t blocks) {
+    ringBlocks = blocks > 0 ? blocks : 1;
+}
+
 // Return the number of samples read in the last operation
 int32 NiDAQHandler::getRead() {
     return read;
@@ -61,6 +67,9 @@ TaskInfo NiDAQHandler::prepareTask(const char* filename) {
 
     // Filter sections related to DAQ channels
     vector<string> filtered_sections = NiDAQfilterSections(ini_data, "DAQmxChannel");
+    vector<string> physicalChannels;   // Channel names for the raw-read property queries
+    vector<double> unitsPerVolt;       // Sensor conversion applied on top of the driver's code-to-volts scaling
+    readMode = ReadMode::Scaled;
 
     try {
         // Create a task handle
@@ -71,23 +80,38 @@ TaskInfo NiDAQHandler::prepareTask(const char* filename) {
             string physicalChannel = ini_data[section]["PhysicalChanName"];
             float64 minVal = stod(ini_data[section]["AI.Min"]);
             float64 maxVal = stod(ini_data[section]["AI.Max"]);
+            string units;
 
             // Configure channels based on their measurement type
             if (channelType == "Analog Input") {
                 string measType = ini_data[section]["AI.MeasType"];
                 if (measType == "Voltage") {
+                    units = "V";
+                    unitsPerVolt.push_back(1.0);
                     DAQmxErrChk(DAQmxCreateAIVoltageChan(taskHandle, physicalChannel.c_str(), "", DAQmx_Val_Cfg_Default, minVal, maxVal, DAQmx_Val_Volts, NULL));
                 }
                 else if (measType == "Current") {
+                    units = "A";
                     float32 shuntResistor = stod(ini_data[section]["AI.CurrentShunt.Resistance"]);
+                    unitsPerVolt.push_back(1.0 / shuntResistor);
                     DAQmxErrChk(DAQmxCreateAICurrentChan(taskHandle, physicalChannel.c_str(), "", DAQmx_Val_RSE, minVal, maxVal, DAQmx_Val_Amps, DAQmx_Val_Internal, shuntResistor, NULL));
                 }
                 else if (measType == "Accelerometer") {
+                    units = "g";
                     double sensitivity = stod(ini_data[section]["AI.Accel.Sensitivity"]);
                     double currentExcitVal = stod(ini_data[section]["AI.Excit.Val"]);
+                    unitsPerVolt.push_back(1000.0 / sensitivity); // Sensitivity is in mV/g
                     DAQmxErrChk(DAQmxCreateAIAccelChan(taskHandle, physicalChannel.c_str(), "", DAQmx_Val_PseudoDiff, minVal, maxVal, DAQmx_Val_AccelUnit_g, sensitivity, DAQmx_Val_mVoltsPerG, DAQmx_Val_Internal, currentExcitVal, NULL));
                 }
             }
+
+            // Keep the channel description for self-describing output files
+            string channelName = section.substr(section.find(' ') + 1);
+            info.channels.push_back({ channelName, units, minVal, maxVal });
+            physicalChannels.push_back(physicalChannel);
+            if (unitsPerVolt.size() < physicalChannels.size()) {
+                unitsPerVolt.push_back(1.0);
+            }
         }
 
         cout << "Channels created successfully." << endl;
@@ -100,15 +124,48 @@ TaskInfo NiDAQHandler::prepareTask(const char* filename) {
             sampleRate = static_cast<int>(floarSampleRate);
             int sampPerChan = stoi(ini_data[task_section]["SampQuant.SampPerChan"]);
             numChannels = static_cast<int>(filtered_sections.size());
-            bufferSize = sampPerChan * numChannels;
-            tmpDataBuffer.resize(bufferSize ,0.0);
-            dataBuffer.resize(bufferSize ,0.0);
+            blockSamples = sampPerChan;
 
             DAQmxErrChk(DAQmxCfgSampClkTiming(taskHandle, "", floarSampleRate, DAQmx_Val_Rising, DAQmx_Val_ContSamps, sampPerChan));
         }
 
+        // Optional [NiDAQ] section with the handler's own settings
+        map<string, string> settings;
+        vector<string> handler_sections = NiDAQfilterSections(ini_data, "NiDAQ");
+        if (!handler_sections.empty()) {
+            settings = ini_data[handler_sections[0]];
+        }
+
+        // blockSamples: samples per channel in every block, independent of the sample rate
+        if (!settings["blockSamples"].empty()) {
+            blockSamples = stoi(settings["blockSamples"]);
+        }
+        bufferSize = blockSamples * numChannels;
+
+        // mode = callback reads each block from DAQmx's EveryNSamples event instead of a read thread
+        acquisitionMode = settings["mode"] == "callback" ? AcquisitionMode::Callback : AcquisitionMode::Thread;
+
+        // inputBufferSamples: driver-side buffer per channel that absorbs consumer stalls
+        if (!settings["inputBufferSamples"].empty()) {
+            DAQmxErrChk(DAQmxCfgInputBuffer(taskHandle, static_cast<uInt32>(stoul(settings["inputBufferSamples"]))));
+        }
+
+        // sampleType = raw keeps ADC codes and defers scaling to the consumers
+        if (settings["sampleType"] == "raw") {
+            prepareRawRead(physicalChannels, unitsPerVolt, info);
+        }
+        cout << "NiDAQ " << (acquisitionMode == AcquisitionMode::Callback ? "callback" : "thread")
+             << " mode, " << blockSamples << " samples per block." << endl;
+
+        // Only the ring of the chosen mode holds memory; the overrun buffer fits any mode
+        ring.reset(readMode == ReadMode::Scaled ? ringBlocks : 0, readMode == ReadMode::Scaled ? bufferSize : 0);
+        rawRing.reset(readMode == ReadMode::Raw16 ? ringBlocks : 0, readMode == ReadMode::Raw16 ? bufferSize : 0);
+        wideRing.reset(readMode == ReadMode::Raw32 ? ringBlocks : 0, readMode == ReadMode::Raw32 ? bufferSize : 0);
+        overrunBuffer.resize(bufferSize, 0.0);
+
         info.sampleRate = sampleRate;
         info.numChannels = numChannels;
+        channels = info.channels;
 
     }
     catch (...) {
@@ -128,6 +185,50 @@ Error:
     return info;
 }
 
+// Query the raw sample size and the driver's code-to-volts polynomial of every channel.
+// Each polynomial is multiplied by the channel's sensor conversion so that consumers
+// get engineering units directly from ChannelInfo::toUnits().
+bool NiDAQHandler::prepareRawRead(const vector<string>& physicalChannels, const vector<double>& unitsPerVolt, TaskInfo& info) {
+    uInt32 rawBits = 0;
+    vector<vector<double>> scaling(physicalChannels.size());
+
+    for (size_t i = 0; i < physicalChannels.size(); ++i) {
+        const char* channel = physicalChannels[i].c_str();
+        uInt32 bits = 0;
+        DAQmxErrChk(DAQmxGetAIRawSampSize(taskHandle, channel, &bits));
+        rawBits = max(rawBits, bits);
+
+        // Called with no array, the query returns the number of coefficients
+        int32 count = DAQmxGetAIDevScalingCoeff(taskHandle, channel, NULL, 0);
+        if (count <= 0) {
+            cerr << "No scaling coefficients for " << physicalChannels[i] << "." << endl;
+            error = count;
+            goto Error;
+        }
+        scaling[i].resize(count);
+        DAQmxErrChk(DAQmxGetAIDevScalingCoeff(taskHandle, channel, scaling[i].data(), count));
+        for (double& coefficient : scaling[i]) {
+            coefficient *= unitsPerVolt[i];
+        }
+    }
+
+    if (rawBits == 0 || rawBits > 32) {
+        cerr << "Unsupported raw sample size: " << rawBits << " bits." << endl;
+        goto Error;
+    }
+
+    readMode = rawBits <= 16 ? ReadMode::Raw16 : ReadMode::Raw32;
+    for (size_t i = 0; i < scaling.size() && i < info.channels.size(); ++i) {
+        info.channels[i].scaling = move(scaling[i]);
+    }
+    cout << "Raw reads enabled: " << rawBits << "-bit codes." << endl;
+    return true;
+
+Error:
+    cerr << "Falling back to scaled reads." << endl;
+    return false;
+}
+
 // Start the DAQ task
 int NiDAQHandler::startTask() {
     if (taskHandle == 0) {
@@ -136,6 +237,15 @@ int NiDAQHandler::startTask() {
     }
 
     try {
+        if (acquisitionMode == AcquisitionMode::Callback) {
+            // The driver calls back every `blockSamples` samples; no read thread is needed
+            DAQmxErrChk(DAQmxRegisterEveryNSamplesEvent(taskHandle, DAQmx_Val_Acquired_Into_Buffer, blockSamples, 0, everyNSamplesCallback, this));
+            running = true;
+            resetSampleClock();
+            DAQmxErrChk(DAQmxStartTask(taskHandle));
+            return 0;
+        }
+        resetSampleClock();
         DAQmxErrChk(DAQmxStartTask(taskHandle));
         running = true;
         readThread = std::thread(&NiDAQHandler::readLoop, this); // Launch the data reading thread
@@ -147,6 +257,7 @@ int NiDAQHandler::startTask() {
     }
 
 Error:
+    running = false;
     if (DAQmxFailed(error)) {
         cerr << "DAQmx Error: " << errBuff << endl;
     }
@@ -156,26 +267,68 @@ Error:
     return 1;
 }
 
+// The sample clock starts with DAQmxStartTask; every later block time is derived from it
+void NiDAQHandler::resetSampleClock() {
+    samplesAcquired = 0;
+    drift.setSampleRate(static_cast<unsigned int>(sampleRate));
+    startTimeNs = monotonicRawNs();
+}
+
+// Read straight into the next free ring slot; if the consumer is behind, read into
+// the overrun buffer so the driver keeps up and count the loss.
+template <typename T, typename ReadFunction>
+int32 NiDAQHandler::readInto(BlockRing<T>& target, ReadFunction readFunction) {
+    typename BlockRing<T>::Slot* slot = target.beginWrite();
+    T* buffer = slot ? slot->data.data() : reinterpret_cast<T*>(overrunBuffer.data());
+
+    int32 status = readFunction(buffer);
+    if (DAQmxFailed(status)) {
+        return status;
+    }
+
+    // Sample-clock time: samples are evenly spaced from the start of the task. The read
+    // returns once the block's last sample is in, which is what `drift` compares against.
+    int64_t timestamp = startTimeNs + framesToNs(samplesAcquired, static_cast<unsigned int>(sampleRate));
+    uint64_t firstSample = samplesAcquired;
+    samplesAcquired += static_cast<uint64_t>(read);
+    drift.addObservation(samplesAcquired, monotonicRawNs());
+    if (alignTimestamps && drift.ready()) {
+        timestamp = drift.alignedNs(firstSample);
+    }
+    if (slot) {
+        target.commitWrite(static_cast<size_t>(read) * numChannels, timestamp);
+        blockReady.notify();
+    } else {
+        target.markDropped();
+    }
+    return status;
+}
+
+// Read exactly one block in the configured read mode
+int32 NiDAQHandler::readNextBlock() {
+    // Scaled reads convert every sample to float64 in the driver; raw reads only copy ADC codes
+    switch (readMode) {
+        case ReadMode::Raw16:
+            return readInto(rawRing, [this](int16* target) {
+                return DAQmxReadBinaryI16(taskHandle, blockSamples, 10.0, DAQmx_Val_GroupByScanNumber, target, bufferSize, &read, NULL);
+            });
+        case ReadMode::Raw32:
+            return readInto(wideRing, [this](int32* target) {
+                return DAQmxReadBinaryI32(taskHandle, blockSamples, 10.0, DAQmx_Val_GroupByScanNumber, target, bufferSize, &read, NULL);
+            });
+        default:
+            return readInto(ring, [this](float64* target) {
+                return DAQmxReadAnalogF64(taskHandle, blockSamples, 10.0, DAQmx_Val_GroupByScanNumber, target, bufferSize, &read, NULL);
+            });
+    }
+}
+
 // Loop for continuously reading data
 void NiDAQHandler::readLoop() {
     while (running) {
         read = 0;
         try {
-            DAQmxErrChk(DAQmxReadAnalogF64(
-                taskHandle,
-                sampleRate,
-                10.0,
-                DAQmx_Val_GroupByScanNumber,
-                tmpDataBuffer.data(),
-                bufferSize,
-                &read,
-                NULL
-            ));
-
-            {
-                std::lock_guard<std::mutex> lock(dataMutex);
-                std::swap(tmpDataBuffer, dataBuffer);
-            }
+            DAQmxErrChk(readNextBlock());
         }
         catch (...) {
             cerr << "Error occurred while reading data." << endl;
@@ -190,15 +343,132 @@ Error:
         cerr << "DAQmx Error: " << errBuff << endl;
     }
     running = false;
+    blockReady.notify(); // Wake the consumer so it does not wait for blocks that never come
+}
+
+// Called by DAQmx once `blockSamples` samples per channel are in the input buffer
+int32 CVICALLBACK NiDAQHandler::everyNSamplesCallback(TaskHandle task, int32 eventType, uInt32 nSamples, void* callbackData) {
+    (void)task;
+    (void)eventType;
+    (void)nSamples;
+    NiDAQHandler* handler = static_cast<NiDAQHandler*>(callbackData);
+    if (!handler->running) {
+        return 0;
+    }
+
+    handler->read = 0;
+    int32 status = handler->readNextBlock();
+    if (DAQmxFailed(status)) {
+        DAQmxGetExtendedErrorInfo(handler->errBuff, 2048);
+        cerr << "DAQmx Error: " << handler->errBuff << endl;
+        handler->running = false;
+        handler->blockReady.notify(); // Wake the consumer so it does not wait for blocks that never come
+        return 0;
+    }
+    handler->readtimes++;
+    return 0;
+}
+
+// Borrow the oldest block that has not been consumed yet
+NiDAQHandler::BlockLease NiDAQHandler::acquireBlock() {
+    return ring.acquireRead();
+}
+
+// Return the descriptor that is signaled for every committed block
+int NiDAQHandler::getEventFd() const {
+    return blockReady.fd();
+}
+
+// Return the number of blocks committed since the last call
+uint64_t NiDAQHandler::drainEvents() {
+    return blockReady.drain();
+}
+
+// Return the number of blocks lost because the ring was full
+uint64_t NiDAQHandler::getDroppedBlocks() const {
+    return ring.droppedBlocks() + rawRing.droppedBlocks() + wideRing.droppedBlocks();
+}
+
+bool NiDAQHandler::getDriftPpm(double& ppm) const {
+    return drift.ppm(ppm);
+}
+
+void NiDAQHandler::setAlignTimestamps(bool align) {
+    alignTimestamps = align;
+}
+
+NiDAQHandler::ReadMode NiDAQHandler::getReadMode() const {
+    return readMode;
+}
+
+// Prepare the task and report whether it produced a usable configuration
+bool NiDAQHandler::configure(const char* filename) {
+    TaskInfo info = prepareTask(filename);
+    return info.sampleRate > 0 && info.numChannels > 0;
+}
+
+bool NiDAQHandler::start() {
+    return startTask() == 0;
+}
+
+void NiDAQHandler::stop() {
+    stopAndClearTask();
+}
+
+// Copy the oldest unread block and release its slot immediately.
+// Raw blocks stay integer codes; ChannelInfo::scaling converts them when needed.
+bool NiDAQHandler::readBlock(DataBlock& block) {
+    if (readMode == ReadMode::Raw16) {
+        BlockRing<int16>::ReadLease lease = rawRing.acquireRead();
+        if (!lease) {
+            return false;
+        }
+        block.format = SampleFormat::Int16;
+        block.codes.assign(lease->data.begin(), lease->data.begin() + lease->count);
+        block.sequence = lease->sequence;
+        block.timestampNs = lease->timestampNs;
+        block.committedNs = lease->committedNs;
+        return true;
+    }
+    if (readMode == ReadMode::Raw32) {
+        BlockRing<int32>::ReadLease lease = wideRing.acquireRead();
+        if (!lease) {
+            return false;
+        }
+        block.format = SampleFormat::Int32;
+        block.wideCodes.assign(lease->data.begin(), lease->data.begin() + lease->count);
+        block.sequence = lease->sequence;
+        block.timestampNs = lease->timestampNs;
+        block.committedNs = lease->committedNs;
+        return true;
+    }
+
+    BlockLease lease = ring.acquireRead();
+    if (!lease) {
+        return false;
+    }
+    block.format = SampleFormat::Float64;
+    block.values.assign(lease->data.begin(), lease->data.begin() + lease->count);
+    block.sequence = lease->sequence;
+    block.timestampNs = lease->timestampNs;
+    block.committedNs = lease->committedNs;
+    return true;
+}
+
+unsigned int NiDAQHandler::getSampleRate() const {
+    return static_cast<unsigned int>(sampleRate);
+}
+
+vector<ChannelInfo> NiDAQHandler::getChannels() const {
+    return channels;
 }
 
-// Return a pointer to the data buffer
-float64* NiDAQHandler::getDataBuffer() {
-    std::lock_guard<std::mutex> lock(dataMutex);
-    return dataBuffer.data();
+uint64_t NiDAQHandler::getBlockCount() const {
+    return static_cast<uint64_t>(readtimes.load());
 }
 
 // Stop the DAQ task and release resources
+// In callback mode DAQmxClearTask unregisters the event and waits for a running callback
 int NiDAQHandler::stopAndClearTask() {
     running = false;
     if (readThread.joinable()) {
@@ -11,6 +11,12 @@
 #include <cstring>
 #include <mutex>
 #include "NIDAQmx.h" // NI-DAQmx library header
+#include "ChannelInfo.h"               // Channel descriptions for output headers
+#include "BlockRing.h"                 // Lock-free ring of acquired blocks
+#include "EventNotifier.h"             // Wakes the consumer when a block is ready
+#include "AcquisitionSource.h"         // Common interface of all devices
+#include "Timestamp.h"                 // CLOCK_MONOTONIC_RAW block timestamps
+#include "DriftEstimator.h"            // Sample-clock drift against CLOCK_MONOTONIC_RAW
 #include "./iniReader/INIReader.h"     // INI file reader
 
 extern "C" {
@@ -23,6 +29,7 @@ using namespace std;
 struct TaskInfo {
     int sampleRate; // Sampling rate in Hz
     int numChannels; // Number of channels being sampled
+    vector<ChannelInfo> channels; // Name, units and range of each channel
 };
 
 // Define a macro for error checking with NI-DAQmx functions
@@ -34,34 +41,89 @@ struct TaskInfo {
     }
 
 // NiDAQHandler class manages the DAQ task
-class NiDAQHandler {
+class NiDAQHandler : public AcquisitionSource {
+public:
+    // How samples are read from the driver.
+    enum class ReadMode {
+        Scaled,  // DAQmxReadAnalogF64: engineering units, 8 bytes per sample
+        Raw16,   // DAQmxReadBinaryI16: ADC codes of devices up to 16 bits
+        Raw32    // DAQmxReadBinaryI32: ADC codes of wider devices, e.g. the 24-bit NI 9234
+    };
+
+    // What triggers each read.
+    enum class AcquisitionMode {
+        Thread,   // A dedicated thread blocks in the read call
+        Callback  // DAQmx's EveryNSamples event reads each block on the driver's thread
+    };
+
 private:
     TaskHandle taskHandle;              // Handle for the DAQ task
     int32 error;                        // Stores error codes
     char errBuff[2048];                 // Buffer for error messages
-    vector<double> tmpDataBuffer;       // Buffer to store acquired data
-    vector<double> dataBuffer;          // Buffer to store acquired data
-    int bufferSize;                     // Size of the data buffer
+    ReadMode readMode;                  // Scaled or raw reads, chosen by prepareTask()
+    AcquisitionMode acquisitionMode;    // Read thread or EveryNSamples callback
+    BlockRing<double> ring;             // Acquired blocks waiting for the consumer (Scaled)
+    BlockRing<int16> rawRing;           // Acquired blocks of raw codes (Raw16)
+    BlockRing<int32> wideRing;          // Acquired blocks of raw codes (Raw32)
+    vector<double> overrunBuffer;       // Read target when the ring is full; big enough for any mode
+    size_t ringBlocks;                  // Number of blocks in the ring
+    int blockSamples;                   // Samples per channel in one block
+    int bufferSize;                     // Size of one data block in samples (all channels)
     int sampleRate;                     // Sampling rate in Hz
     int numChannels;                    // Number of channels in the task
+    vector<ChannelInfo> channels;       // Name, units and range of each channel
     atomic<bool> running;               // Atomic flag for controlling the data read loop
     thread readThread;                  // Thread for handling data acquisition
     int32 read;                         // Number of samples read in the last read operation
-    int readtimes;                      // Total number of read operations performed
-    std::mutex dataMutex;               // Mutex for protecting data access
+    int64_t startTimeNs;                // CLOCK_MONOTONIC_RAW time of the first sample
+    uint64_t samplesAcquired;           // Samples per channel read since the task started, dropped blocks included
+    DriftEstimator drift;               // Compares samplesAcquired with the time each read returns
+    bool alignTimestamps;               // Stamp blocks from the drift fit instead of the nominal rate
+    atomic<int> readtimes;              // Total number of read operations performed
+    EventNotifier blockReady;           // Signaled after every committed block
 
     void readLoop();                    // Internal function for continuous data acquisition
+    int32 readNextBlock();              // Read one block of `blockSamples` samples per channel
+    void resetSampleClock();            // Start the block clock; call right before DAQmxStartTask
+
+    // EveryNSamples event handler; `callbackData` is the handler
+    static int32 CVICALLBACK everyNSamplesCallback(TaskHandle task, int32 eventType, uInt32 nSamples, void* callbackData);
+
+    // Reads the next block into a free slot of `target`, or into the overrun buffer when it is full.
+    template <typename T, typename ReadFunction>
+    int32 readInto(BlockRing<T>& target, ReadFunction readFunction);
+
+    // Switches to a raw mode and fills each channel's scaling polynomial; false keeps Scaled mode.
+    bool prepareRawRead(const vector<string>& physicalChannels, const vector<double>& unitsPerVolt, TaskInfo& info);
 
 public:
+    typedef BlockRing<double>::ReadLease BlockLease;
+
     NiDAQHandler();                     // Constructor to initialize the handler
-    ~NiDAQHandler();                    // Destructor to clean up resources
+    ~NiDAQHandler() override;           // Destructor to clean up resources
 
+    void setRingBlocks(size_t blocks) override; // Set the ring capacity; call before prepareTask
     TaskInfo prepareTask(const char* filename); // Prepare the DAQ task using an INI file
     int startTask();                            // Start the DAQ task
     int32 getRead();                            // Get the number of samples read in the last operation
     int getReadTimes();                         // Get the total number of read operations
-    double* getDataBuffer();                   // Retrieve the pointer to the data buffer
+    BlockLease acquireBlock();                  // Borrow the oldest unread block, empty if none (Scaled mode)
+    ReadMode getReadMode() const;               // Mode chosen by prepareTask()
     int stopAndClearTask();                     // Stop the DAQ task and clear resources
+
+    // AcquisitionSource interface
+    bool configure(const char* filename) override;      // prepareTask() and check the result
+    bool start() override;                              // startTask()
+    void stop() override;                               // stopAndClearTask()
+    bool readBlock(DataBlock& block) override;          // Copy the oldest unread block; raw modes yield integer codes
+    int getEventFd() const override;                    // Descriptor that becomes readable when a block is ready
+    uint64_t drainEvents() override;                    // Clear the descriptor; blocks signaled since the last call
+    unsigned int getSampleRate() const override;        // Sampling rate in Hz
+    vector<ChannelInfo> getChannels() const override;   // Channels parsed by prepareTask(), with raw scaling if any
+    uint64_t getBlockCount() const override;            // Same as getReadTimes()
+    uint64_t getDroppedBlocks() const override;         // Blocks lost because the consumer fell behind
+    bool getDriftPpm(double& ppm) const override;       // Sample-clock error measured by `drift`
+    void setAlignTimestamps(bool align) override;       // Use the drift fit for block timestamps
 };
 
 #endif // NiDAQ_H
@@ -0,0 +1,73 @@
+#include "ParallelEncoder.h"
+
+// Bytes a block holds while in flight: its samples plus an encoding of at most the same size.
+static size_t blockFootprint(const DataBlock& block) {
+    return 2 * (block.values.size() * sizeof(double) + block.codes.size() * sizeof(int16_t) +
+                block.wideCodes.size() * sizeof(int32_t));
+}
+
+ParallelEncoder::ParallelEncoder(unique_ptr<DataWriter> writer, CompressionPool& pool)
+    : writer(move(writer)), pool(pool), writing(false) {}
+
+ParallelEncoder::~ParallelEncoder() {
+    drain();
+}
+
+void ParallelEncoder::addDataBlock(DataBlock&& block) {
+    if (!writer->encodesInParallel()) {
+        writer->addDataBlock(move(block));
+        return;
+    }
+
+    auto job = make_unique<Job>();
+    job->format = block.format;
+    job->timestampNs = block.timestampNs;
+    job->reserved = blockFootprint(block);
+    job->done = false;
+    job->block = move(block);
+    pool.reserve(job->reserved);
+
+    Job* task = job.get();
+    {
+        lock_guard<mutex> guard(lock);
+        pending.push_back(move(job));
+    }
+    pool.submit([this, task] { encode(task); });
+}
+
+void ParallelEncoder::updateFilename() {
+    drain();
+    writer->updateFilename();
+}
+
+// Only one worker writes at a time; a worker that finishes while another is writing
+// leaves its block for that one, which checks the front again after every write.
+// The final notify happens with the lock held: once it is released, drain() may
+// return and the encoder be destroyed, so no member is touched after that.
+void ParallelEncoder::encode(Job* job) {
+    writer->encodeBlock(job->block, job->bytes);
+    job->block = DataBlock();
+
+    unique_lock<mutex> guard(lock);
+    job->done = true;
+    if (writing) {
+        return;
+    }
+    writing = true;
+    while (!pending.empty() && pending.front()->done) {
+        unique_ptr<Job> next = move(pending.front());
+        pending.pop_front();
+        guard.unlock();
+        writer->writeEncodedBlock(next->bytes, next->format, next->timestampNs);
+        pool.release(next->reserved);
+        next.reset();
+        guard.lock();
+    }
+    writing = false;
+    written.notify_all();
+}
+
+void ParallelEncoder::drain() {
+    unique_lock<mutex> guard(lock);
+    written.wait(guard, [&] { return pending.empty() && !writing; });
+}
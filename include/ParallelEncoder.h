@@ -0,0 +1,61 @@
+#ifndef PARALLEL_ENCODER_H
+#define PARALLEL_ENCODER_H
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include "DataWriter.h"
+#include "CompressionPool.h"
+
+using namespace std;
+
+// ParallelEncoder sits in front of a writer that encodesInParallel() and fans its
+// blocks out to a CompressionPool, one block per task, so a stream is no longer
+// limited to what one core can compress. Finished blocks are handed to the writer
+// strictly in the order they arrived: whichever worker completes the oldest pending
+// block writes it, followed by every block after it that is already done.
+// Writers that do not encode in parallel are called directly.
+class ParallelEncoder : public DataWriter {
+public:
+    // Constructor: Encodes `writer`'s blocks on `pool`, which must outlive this object.
+    ParallelEncoder(unique_ptr<DataWriter> writer, CompressionPool& pool);
+
+    // Destructor: Waits until every block has been written.
+    ~ParallelEncoder() override;
+
+    // Reserves the block's share of the pool's memory budget (waiting if it is used up)
+    // and queues it for encoding.
+    void addDataBlock(DataBlock&& block) override;
+    using DataWriter::addDataBlock;
+
+    // Rotates the file once every block queued before it has been written.
+    void updateFilename() override;
+
+private:
+    // One block on its way through the pool.
+    struct Job {
+        DataBlock block;          // Samples to encode, released once encoded
+        SampleFormat format;      // Format of the block, for the file header
+        int64_t timestampNs;      // Acquisition time of the block, for the file header
+        vector<uint8_t> bytes;    // Encoded block
+        size_t reserved;          // Budget taken from the pool
+        bool done;                // Encoded and waiting to be written
+    };
+
+    unique_ptr<DataWriter> writer;       // Writer receiving the encoded blocks
+    CompressionPool& pool;               // Shared workers and memory budget
+    deque<unique_ptr<Job>> pending;      // Blocks not written yet, in arrival order
+    bool writing;                        // A worker is writing finished blocks
+    mutex lock;                          // Guards pending and writing
+    condition_variable written;          // Signaled whenever pending shrinks
+
+    // Worker task: encodes one block and writes whatever is ready in order.
+    void encode(Job* job);
+
+    // Waits until every queued block has been written.
+    void drain();
+};
+
+#endif // PARALLEL_ENCODER_H
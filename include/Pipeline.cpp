@@ -0,0 +1,117 @@
+#include "Pipeline.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+// epoll user data marking the input descriptor instead of a stream index.
+static const uint64_t INPUT_EVENT = UINT64_MAX;
+
+Pipeline::Pipeline(bool verbose)
+    : epollFd(epoll_create1(EPOLL_CLOEXEC)), inputFd(-1), verbose(verbose) {
+    if (epollFd < 0) {
+        cerr << "Failed to create epoll set: " << strerror(errno) << endl;
+    }
+}
+
+Pipeline::~Pipeline() {
+    if (epollFd >= 0) {
+        close(epollFd);
+    }
+}
+
+bool Pipeline::addStream(const string& name, AcquisitionSource* source, unique_ptr<AsyncWriter> writer) {
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = streams.size();
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, source->getEventFd(), &event) < 0) {
+        cerr << "Cannot watch " << name << ": " << strerror(errno) << endl;
+        return false;
+    }
+    streams.push_back({ name, source, move(writer), 0, {} });
+    return true;
+}
+
+bool Pipeline::watchInput(int fd) {
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = INPUT_EVENT;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        cerr << "Cannot watch input: " << strerror(errno) << endl;
+        return false;
+    }
+    inputFd = fd;
+    return true;
+}
+
+void Pipeline::unwatchInput() {
+    if (inputFd >= 0) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, inputFd, nullptr);
+        inputFd = -1;
+    }
+}
+
+bool Pipeline::waitAndService(int timeoutMs) {
+    struct epoll_event events[16];
+    int count = epoll_wait(epollFd, events, 16, timeoutMs);
+    if (count < 0) {
+        if (errno != EINTR) {
+            cerr << "epoll_wait failed: " << strerror(errno) << endl;
+        }
+        return false;
+    }
+
+    bool inputReady = false;
+    for (int i = 0; i < count; ++i) {
+        if (events[i].data.u64 == INPUT_EVENT) {
+            inputReady = true;
+            continue;
+        }
+        Stream& stream = streams[events[i].data.u64];
+        // Reset the eventfd counter before draining so no signal is missed. Only the
+        // blocks signaled so far are serviced; a source that commits faster than its
+        // writer keeps then cannot hold this loop, and later blocks wake us again.
+        service(stream, stream.source->drainEvents());
+    }
+    return inputReady;
+}
+
+void Pipeline::serviceAll() {
+    for (Stream& stream : streams) {
+        service(stream, UINT64_MAX);
+    }
+}
+
+// The final drift estimate is reported so long runs can be checked against each other.
+void Pipeline::stopAll() {
+    for (Stream& stream : streams) {
+        stream.source->stop();
+        double ppm;
+        if (verbose && stream.source->getDriftPpm(ppm)) {
+            cout << stream.name << " sample clock drift: " << showpos << ppm << noshowpos << " ppm" << endl;
+        }
+    }
+}
+
+void Pipeline::service(Stream& stream, uint64_t maxBlocks) {
+    for (uint64_t serviced = 0; serviced < maxBlocks && stream.source->readBlock(stream.block); ++serviced) {
+        stream.writer->addDataBlock(move(stream.block));
+        stream.block = DataBlock();
+
+        stream.programTimer++;
+        if (verbose) {
+            cout << "=========================================" << endl;
+            cout << stream.name << " Program Timer: " << stream.programTimer << endl;
+            cout << stream.name << " Package Timer: " << stream.source->getBlockCount()
+                 << " (lost " << stream.source->getDroppedBlocks() << ")" << endl;
+            cout << stream.name << " Queue Depth:   " << stream.writer->queueDepth() << " (dropped "
+                 << stream.writer->droppedBlocks() << ", spilled " << stream.writer->spilledBlocks() << ")" << endl;
+            double ppm;
+            if (stream.source->getDriftPpm(ppm)) {
+                cout << stream.name << " Clock Drift:   " << showpos << ppm << noshowpos << " ppm" << endl;
+            }
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "AcquisitionSource.h"
+#include "AsyncWriter.h"
+
+using namespace std;
+
+// Pipeline moves blocks from any number of acquisition sources to their writers.
+// All block-ready descriptors sit in one epoll set, so only sources that actually
+// have data are touched; idle sources cost nothing per wakeup.
+class Pipeline {
+public:
+    // Constructor: `verbose` prints a status report for every block.
+    explicit Pipeline(bool verbose = true);
+
+    // Destructor: Closes the epoll descriptor; writers flush when destroyed.
+    ~Pipeline();
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    // Connects a source to its writer. The source must outlive the pipeline.
+    // Files are rotated by the writer, e.g. a RotatingWriter behind the AsyncWriter.
+    bool addStream(const string& name, AcquisitionSource* source, unique_ptr<AsyncWriter> writer);
+
+    // Also wakes up when `fd` (e.g. stdin) becomes readable.
+    bool watchInput(int fd);
+
+    // Stops waking up for the input descriptor.
+    void unwatchInput();
+
+    // Sleeps until a source or the input is ready and services every ready source.
+    // Returns true when the input descriptor is readable.
+    bool waitAndService(int timeoutMs);
+
+    // Writes every block still waiting in any source.
+    void serviceAll();
+
+    // Stops every source.
+    void stopAll();
+
+private:
+    // One source and where its blocks go.
+    struct Stream {
+        string name;                   // Device name used in status output
+        AcquisitionSource* source;     // Producer of blocks
+        unique_ptr<AsyncWriter> writer;// Consumer of blocks
+        int programTimer;              // Blocks written in this run
+        DataBlock block;               // Block being handed over
+    };
+
+    vector<Stream> streams;  // All connected streams
+    int epollFd;             // epoll set of all block-ready descriptors
+    int inputFd;             // Watched input descriptor, -1 if none
+    bool verbose;            // Print per-block status
+
+    // Hands up to `maxBlocks` ready blocks of one stream to its writer.
+    void service(Stream& stream, uint64_t maxBlocks);
+};
+
+#endif // PIPELINE_H
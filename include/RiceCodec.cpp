@@ -0,0 +1,343 @@
+#include "RiceCodec.h"
+#include <cstring>
+#include <algorithm>
+
+namespace {
+
+// Writes bits most significant first into a buffer that must not overrun `limit`.
+class BitWriter {
+public:
+    BitWriter(uint8_t* out, uint8_t* limit) : out(out), limit(limit), acc(0), used(0), full(false) {}
+
+    // Appends the low `bits` bits of `value`; `bits` <= 32 and the rest of `value` zero.
+    void put(uint64_t value, unsigned int bits) {
+        acc = (acc << bits) | value;
+        used += bits;
+        if (used >= 32) {
+            used -= 32;
+            uint32_t word = static_cast<uint32_t>(acc >> used);
+            if (out + 4 > limit) {
+                full = true;
+                return;
+            }
+            out[0] = static_cast<uint8_t>(word >> 24);
+            out[1] = static_cast<uint8_t>(word >> 16);
+            out[2] = static_cast<uint8_t>(word >> 8);
+            out[3] = static_cast<uint8_t>(word);
+            out += 4;
+        }
+    }
+
+    // Appends up to 64 bits.
+    void putLong(uint64_t value, unsigned int bits) {
+        if (bits > 32) {
+            put(value >> 32, bits - 32);
+            put(value & 0xFFFFFFFFull, 32);
+        } else {
+            put(value, bits);
+        }
+    }
+
+    // Pads to a byte boundary and returns the end of the written data.
+    uint8_t* finish() {
+        while (used > 0 && !full) {
+            unsigned int bits = min(used, 8u);
+            uint8_t byte = static_cast<uint8_t>((acc >> (used - bits)) << (8 - bits));
+            if (out >= limit) {
+                full = true;
+                break;
+            }
+            *out++ = byte;
+            used -= bits;
+        }
+        return out;
+    }
+
+    // True once the output would have passed `limit`.
+    bool overflowed() const { return full; }
+
+private:
+    uint8_t* out;      // Next byte to write
+    uint8_t* limit;    // End of the available space
+    uint64_t acc;      // Pending bits, the newest in the low `used` bits
+    unsigned int used; // Pending bits not yet written
+    bool full;         // `limit` was reached
+};
+
+// Reads bits most significant first.
+class BitReader {
+public:
+    BitReader(const uint8_t* data, size_t size) : begin(data), data(data), end(data + size), acc(0), avail(0) {}
+
+    // Reads `bits` <= 32 bits; false if the data ends first.
+    bool get(unsigned int bits, uint64_t& value) {
+        if (bits == 0) {
+            value = 0;
+            return true;
+        }
+        refill();
+        if (avail < bits) {
+            return false;
+        }
+        value = acc >> (64 - bits);
+        acc <<= bits;
+        avail -= bits;
+        return true;
+    }
+
+    // Reads up to 64 bits.
+    bool getLong(unsigned int bits, uint64_t& value) {
+        if (bits <= 32) {
+            return get(bits, value);
+        }
+        uint64_t high, low;
+        if (!get(bits - 32, high) || !get(32, low)) {
+            return false;
+        }
+        value = (high << 32) | low;
+        return true;
+    }
+
+    // Counts zero bits up to the terminating one bit, or up to `escape` zero bits.
+    bool unary(unsigned int escape, unsigned int& zeros) {
+        refill();
+        unsigned int z = acc ? static_cast<unsigned int>(__builtin_clzll(acc)) : 64;
+        if (z >= escape && avail >= escape) {
+            zeros = escape;
+            acc <<= escape;
+            avail -= escape;
+            return true;
+        }
+        if (z >= avail) {
+            return false;
+        }
+        zeros = z;
+        acc <<= z + 1;
+        avail -= z + 1;
+        return true;
+    }
+
+    // Bytes consumed, counting the padding of the last partial byte.
+    size_t consumed() const {
+        return static_cast<size_t>(data - begin) - avail / 8;
+    }
+
+private:
+    const uint8_t* begin; // Start of the data
+    const uint8_t* data;  // Next byte to load
+    const uint8_t* end;   // End of the data
+    uint64_t acc;         // Loaded bits, the next one in the top bit
+    unsigned int avail;   // Loaded bits not yet consumed
+
+    void refill() {
+        while (avail <= 56 && data < end) {
+            acc |= static_cast<uint64_t>(*data++) << (56 - avail);
+            avail += 8;
+        }
+    }
+};
+
+inline uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// Prediction of sample i from the `order` samples before it (fixed polynomial predictors).
+template <typename T>
+inline int64_t predict(const T* x, size_t i, unsigned int order) {
+    switch (order) {
+        case 1:  return x[i - 1];
+        case 2:  return 2 * int64_t(x[i - 1]) - x[i - 2];
+        case 3:  return 3 * int64_t(x[i - 1]) - 3 * int64_t(x[i - 2]) + x[i - 3];
+        case 4:  return 4 * int64_t(x[i - 1]) - 6 * int64_t(x[i - 2]) + 4 * int64_t(x[i - 3]) - x[i - 4];
+        default: return 0;
+    }
+}
+
+// Zig-zag mapped residuals of samples [order, count); one loop per order so each is branch-free.
+template <typename T>
+void computeResiduals(const T* x, size_t count, unsigned int order, uint64_t* u) {
+    switch (order) {
+        case 0:
+            for (size_t i = 0; i < count; ++i) u[i] = zigzag(x[i]);
+            break;
+        case 1:
+            for (size_t i = 1; i < count; ++i) u[i - 1] = zigzag(x[i] - predict(x, i, 1));
+            break;
+        case 2:
+            for (size_t i = 2; i < count; ++i) u[i - 2] = zigzag(x[i] - predict(x, i, 2));
+            break;
+        case 3:
+            for (size_t i = 3; i < count; ++i) u[i - 3] = zigzag(x[i] - predict(x, i, 3));
+            break;
+        default:
+            for (size_t i = 4; i < count; ++i) u[i - 4] = zigzag(x[i] - predict(x, i, 4));
+            break;
+    }
+}
+
+// Rice parameter that roughly minimizes the coded size of `n` values summing to `sum`.
+inline unsigned int riceParameter(uint64_t sum, size_t n, unsigned int maxK) {
+    unsigned int k = 0;
+    while (k < maxK && (static_cast<uint64_t>(n) << (k + 1)) < sum) {
+        ++k;
+    }
+    return k;
+}
+
+} // namespace
+
+// The residual sums of all orders come out of one pass: each order's residual is the
+// difference of the next lower order's residuals.
+template <typename T>
+unsigned int RiceCodec::chooseOrder(const T* x, size_t count) {
+    if (count <= MAX_ORDER) {
+        return 0;
+    }
+    int64_t last0 = x[3];
+    int64_t last1 = int64_t(x[3]) - x[2];
+    int64_t last2 = last1 - (int64_t(x[2]) - x[1]);
+    int64_t last3 = last2 - (int64_t(x[2]) - 2 * int64_t(x[1]) + x[0]);
+    uint64_t sum[MAX_ORDER + 1] = {};
+    for (size_t i = MAX_ORDER; i < count; ++i) {
+        int64_t e0 = x[i];
+        int64_t e1 = e0 - last0;
+        int64_t e2 = e1 - last1;
+        int64_t e3 = e2 - last2;
+        int64_t e4 = e3 - last3;
+        sum[0] += static_cast<uint64_t>(e0 < 0 ? -e0 : e0);
+        sum[1] += static_cast<uint64_t>(e1 < 0 ? -e1 : e1);
+        sum[2] += static_cast<uint64_t>(e2 < 0 ? -e2 : e2);
+        sum[3] += static_cast<uint64_t>(e3 < 0 ? -e3 : e3);
+        sum[4] += static_cast<uint64_t>(e4 < 0 ? -e4 : e4);
+        last0 = e0;
+        last1 = e1;
+        last2 = e2;
+        last3 = e3;
+    }
+    return static_cast<unsigned int>(min_element(sum, sum + MAX_ORDER + 1) - sum);
+}
+
+template <typename T>
+void RiceCodec::encode(const T* samples, size_t count, vector<uint8_t>& out) {
+    const unsigned int sampleBits = sizeof(T) * 8;
+    const size_t start = out.size();
+    const size_t verbatimBytes = 1 + count * sizeof(T);
+    const uint64_t sampleMask = (1ull << sampleBits) - 1;
+
+    // Rice coding may not take more room than storing the samples verbatim
+    out.resize(start + verbatimBytes);
+    unsigned int order = chooseOrder(samples, count);
+    const unsigned int residualBits = sampleBits + order + 1;
+    BitWriter bits(out.data() + start, out.data() + start + verbatimBytes);
+    bits.put(order, 8);
+    for (size_t i = 0; i < order; ++i) {
+        bits.put(static_cast<uint64_t>(samples[i]) & sampleMask, sampleBits);
+    }
+
+    static thread_local vector<uint64_t> residuals;
+    residuals.resize(count);
+    computeResiduals(samples, count, order, residuals.data());
+    const size_t n = count - order;
+    for (size_t p = 0; p < n && !bits.overflowed(); p += PARTITION_SIZE) {
+        const uint64_t* u = residuals.data() + p;
+        const size_t length = min(PARTITION_SIZE, n - p);
+        uint64_t sum = 0;
+        for (size_t i = 0; i < length; ++i) {
+            sum += u[i];
+        }
+        const unsigned int k = riceParameter(sum, length, residualBits);
+        const uint64_t lowMask = (1ull << k) - 1;
+        bits.put(k, K_BITS);
+        for (size_t i = 0; i < length; ++i) {
+            uint64_t q = u[i] >> k;
+            if (q >= ESCAPE) {
+                bits.put(0, ESCAPE);
+                bits.putLong(u[i], residualBits);
+            } else if (q + 1 + k <= 32) {
+                bits.put((1ull << k) | (u[i] & lowMask), static_cast<unsigned int>(q) + 1 + k);
+            } else {
+                bits.put(1, static_cast<unsigned int>(q) + 1);
+                bits.putLong(u[i] & lowMask, k);
+            }
+        }
+    }
+    uint8_t* end = bits.finish();
+
+    if (bits.overflowed()) {
+        // Incompressible, e.g. white noise at full scale
+        BitWriter raw(out.data() + start, out.data() + start + verbatimBytes);
+        raw.put(VERBATIM, 8);
+        for (size_t i = 0; i < count; ++i) {
+            raw.put(static_cast<uint64_t>(samples[i]) & sampleMask, sampleBits);
+        }
+        end = raw.finish();
+    }
+    out.resize(static_cast<size_t>(end - out.data()));
+}
+
+template <typename T>
+size_t RiceCodec::decode(const uint8_t* data, size_t size, T* samples, size_t count) {
+    const unsigned int sampleBits = sizeof(T) * 8;
+    BitReader bits(data, size);
+    uint64_t value;
+    if (!bits.get(8, value)) {
+        return 0;
+    }
+    const unsigned int order = static_cast<unsigned int>(value);
+    if (order == VERBATIM) {
+        for (size_t i = 0; i < count; ++i) {
+            if (!bits.get(sampleBits, value)) {
+                return 0;
+            }
+            samples[i] = static_cast<T>(value);
+        }
+        return bits.consumed();
+    }
+    if (order > MAX_ORDER || (count > 0 && order > count)) {
+        return 0;
+    }
+
+    const unsigned int residualBits = sampleBits + order + 1;
+    for (size_t i = 0; i < order; ++i) {
+        if (!bits.get(sampleBits, value)) {
+            return 0;
+        }
+        samples[i] = static_cast<T>(value);
+    }
+    for (size_t p = order; p < count; p += PARTITION_SIZE) {
+        const size_t last = min(p + PARTITION_SIZE, count);
+        uint64_t k;
+        if (!bits.get(K_BITS, k) || k > residualBits) {
+            return 0;
+        }
+        for (size_t i = p; i < last; ++i) {
+            unsigned int q;
+            uint64_t u;
+            if (!bits.unary(ESCAPE, q)) {
+                return 0;
+            }
+            if (q == ESCAPE) {
+                if (!bits.getLong(residualBits, u)) {
+                    return 0;
+                }
+            } else {
+                uint64_t low;
+                if (!bits.getLong(static_cast<unsigned int>(k), low)) {
+                    return 0;
+                }
+                u = (static_cast<uint64_t>(q) << k) | low;
+            }
+            samples[i] = static_cast<T>(unzigzag(u) + predict(samples, i, order));
+        }
+    }
+    return bits.consumed();
+}
+
+template void RiceCodec::encode<int16_t>(const int16_t*, size_t, vector<uint8_t>&);
+template void RiceCodec::encode<int32_t>(const int32_t*, size_t, vector<uint8_t>&);
+template size_t RiceCodec::decode<int16_t>(const uint8_t*, size_t, int16_t*, size_t);
+template size_t RiceCodec::decode<int32_t>(const uint8_t*, size_t, int32_t*, size_t);
@@ -0,0 +1,47 @@
+#ifndef RICE_CODEC_H
+#define RICE_CODEC_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// RiceCodec losslessly compresses one channel of integer samples, in the manner of
+// FLAC's fixed subframes: a polynomial predictor of order 0-4 is chosen per call,
+// the prediction residuals are zig-zag mapped to unsigned values and Rice coded with
+// a parameter chosen per partition of PARTITION_SIZE residuals. Blocks that would
+// grow are stored verbatim.
+//
+// Encoding of one channel (bit stream, most significant bit first, byte aligned at the end):
+//   8 bits   predictor order 0-4, or VERBATIM
+//   VERBATIM: every sample in its full width (two's complement)
+//   else:    the first `order` samples in full width, then per partition of residuals
+//            6 bits Rice parameter k, and per residual u = zigzag(residual):
+//              q = u >> k zero bits, a one bit, the low k bits of u;
+//              or, when q >= ESCAPE, ESCAPE zero bits and u in full residual width
+class RiceCodec {
+public:
+    static const size_t PARTITION_SIZE = 256; // Residuals sharing one Rice parameter
+
+    // Appends the encoding of `count` samples to `out`. T is int16_t or int32_t.
+    template <typename T>
+    static void encode(const T* samples, size_t count, vector<uint8_t>& out);
+
+    // Decodes `count` samples from `data`. Returns the number of bytes consumed,
+    // or 0 if the data is truncated or corrupt.
+    template <typename T>
+    static size_t decode(const uint8_t* data, size_t size, T* samples, size_t count);
+
+private:
+    static const unsigned int MAX_ORDER = 4;   // Highest predictor order
+    static const unsigned int VERBATIM = 0xFF; // Order byte of an uncompressed channel
+    static const unsigned int ESCAPE = 31;     // Quotients from here on are stored verbatim
+    static const unsigned int K_BITS = 6;      // Width of a Rice parameter
+
+    // Order whose residuals have the smallest sum of magnitudes.
+    template <typename T>
+    static unsigned int chooseOrder(const T* samples, size_t count);
+};
+
+#endif // RICE_CODEC_H
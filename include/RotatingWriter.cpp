@@ -0,0 +1,55 @@
+#include "RotatingWriter.h"
+#include "Timestamp.h"
+#include <algorithm>
+
+RotatingWriter::RotatingWriter(unique_ptr<DataWriter> writer, uint64_t framesPerFile, size_t numChannels, unsigned int sampleRate)
+    : writer(move(writer)), framesPerFile(max<uint64_t>(framesPerFile, 1)),
+      numChannels(max<size_t>(numChannels, 1)), sampleRate(sampleRate), fileFrames(0) {}
+
+// A full file is only closed when the next block arrives, so the end of a run
+// leaves no empty file behind.
+void RotatingWriter::addDataBlock(DataBlock&& block) {
+    while (true) {
+        if (fileFrames >= framesPerFile) {
+            writer->updateFilename();
+            fileFrames = 0;
+        }
+        uint64_t frames = block.size() / numChannels;
+        uint64_t room = framesPerFile - fileFrames;
+        if (frames <= room) {
+            fileFrames += frames;
+            writer->addDataBlock(move(block));
+            return;
+        }
+        DataBlock tail = splitAt(block, static_cast<size_t>(room));
+        fileFrames += room;
+        writer->addDataBlock(move(block));
+        block = move(tail);
+    }
+}
+
+void RotatingWriter::updateFilename() {
+    writer->updateFilename();
+    fileFrames = 0;
+}
+
+// Both parts keep the source's sequence number; the tail's timestamp is that of its first frame.
+DataBlock RotatingWriter::splitAt(DataBlock& block, size_t frame) const {
+    DataBlock tail;
+    tail.format = block.format;
+    tail.sequence = block.sequence;
+    tail.timestampNs = block.timestampNs != 0 ? block.timestampNs + framesToNs(frame, sampleRate) : 0;
+    tail.committedNs = block.committedNs;
+
+    const size_t split = frame * numChannels;
+    auto cut = [split](auto& head, auto& rest) {
+        rest.assign(head.begin() + split, head.end());
+        head.resize(split);
+    };
+    switch (block.format) {
+        case SampleFormat::Int16: cut(block.codes, tail.codes); break;
+        case SampleFormat::Int32: cut(block.wideCodes, tail.wideCodes); break;
+        default:                  cut(block.values, tail.values); break;
+    }
+    return tail;
+}
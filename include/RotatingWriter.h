@@ -0,0 +1,39 @@
+#ifndef ROTATING_WRITER_H
+#define ROTATING_WRITER_H
+
+#include <memory>
+#include <cstdint>
+#include "DataWriter.h"
+
+using namespace std;
+
+// RotatingWriter starts a new file of another DataWriter every `framesPerFile`
+// samples per channel. Blocks need not be a second long or even all the same
+// length: a block that crosses the boundary is split, its head completing the
+// current file and its tail opening the next one, so every file but the last of
+// a run holds exactly `framesPerFile` samples per channel.
+class RotatingWriter : public DataWriter {
+public:
+    // Constructor: Rotates `writer` every `framesPerFile` frames of `numChannels` interleaved
+    // channels; `sampleRate` dates the tail of a split block.
+    RotatingWriter(unique_ptr<DataWriter> writer, uint64_t framesPerFile, size_t numChannels, unsigned int sampleRate);
+
+    // Writes the block, splitting it at a file boundary if it crosses one.
+    void addDataBlock(DataBlock&& block) override;
+    using DataWriter::addDataBlock;
+
+    // Starts a new file right away and restarts the count.
+    void updateFilename() override;
+
+private:
+    unique_ptr<DataWriter> writer;  // Writer whose files are rotated
+    uint64_t framesPerFile;         // Samples per channel in each file
+    size_t numChannels;             // Interleaved channels per frame
+    unsigned int sampleRate;        // Sampling rate in Hz
+    uint64_t fileFrames;            // Samples per channel already in the current file
+
+    // Moves the frames from `frame` on out of `block` into a new block.
+    DataBlock splitAt(DataBlock& block, size_t frame) const;
+};
+
+#endif // ROTATING_WRITER_H
@@ -0,0 +1,140 @@
+#include "SegmentPreparer.h"
+#include <iostream>
+#include <cerrno>
+#include <cstring>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+SegmentPreparer::SegmentPreparer(uint64_t bytes)
+    : bytes(bytes), readyFd(-1), readyTruncate(false), warned(false), stopping(false) {
+    worker = thread(&SegmentPreparer::run, this);
+}
+
+// Closing an unnamed file that was never linked deletes it.
+SegmentPreparer::~SegmentPreparer() {
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    work.notify_all();
+    worker.join();
+    if (readyFd >= 0) {
+        ::close(readyFd);
+    }
+}
+
+void SegmentPreparer::prepare(const string& directory, bool truncate) {
+    submit([this, directory, truncate] { create(directory, truncate); });
+}
+
+// The link is queued ahead of the file's retire(), which closes the descriptor.
+int SegmentPreparer::take(const string& filename, bool truncate) {
+    int fd;
+    {
+        lock_guard<mutex> guard(lock);
+        if (readyFd < 0 || readyTruncate != truncate || readyDirectory != directoryOf(filename)) {
+            return -1;
+        }
+        fd = readyFd;
+        readyFd = -1;
+    }
+    submit([this, fd, filename, truncate] { link(fd, filename, truncate); });
+    return fd;
+}
+
+// Allocation beyond the end of the file is kept by KEEP_SIZE; truncating to the
+// current size releases it.
+void SegmentPreparer::retire(int fd) {
+    submit([fd] {
+        struct stat info;
+        if (fstat(fd, &info) == 0 && ftruncate(fd, info.st_size) != 0) {
+            cerr << "Failed to trim file: " << strerror(errno) << endl;
+        }
+        ::close(fd);
+    });
+}
+
+string SegmentPreparer::directoryOf(const string& filename) {
+    size_t slash = filename.find_last_of('/');
+    if (slash == string::npos) {
+        return ".";
+    }
+    return slash == 0 ? "/" : filename.substr(0, slash);
+}
+
+// The file is linked through /proc because linkat(AT_EMPTY_PATH) needs privileges.
+// linkat never replaces a name, so a file that appeared in the meantime is replaced
+// through a rename for truncating opens and kept for appending ones.
+void SegmentPreparer::link(int fd, const string& filename, bool truncate) {
+    string path = "/proc/self/fd/" + to_string(fd);
+    if (linkat(AT_FDCWD, path.c_str(), AT_FDCWD, filename.c_str(), AT_SYMLINK_FOLLOW) == 0) {
+        return;
+    }
+    if (errno == EEXIST) {
+        string spare = filename + ".new";
+        ::unlink(spare.c_str());
+        if (linkat(AT_FDCWD, path.c_str(), AT_FDCWD, spare.c_str(), AT_SYMLINK_FOLLOW) == 0) {
+            if (!truncate) {
+                cerr << "File " << filename << " already exists, writing " << spare << " instead" << endl;
+                return;
+            }
+            if (rename(spare.c_str(), filename.c_str()) == 0) {
+                return;
+            }
+        }
+    }
+    cerr << "Failed to name file: " << filename << " (" << strerror(errno) << ")" << endl;
+}
+
+void SegmentPreparer::submit(function<void()> task) {
+    {
+        lock_guard<mutex> guard(lock);
+        tasks.push_back(move(task));
+    }
+    work.notify_one();
+}
+
+// Tasks left at shutdown still run, so every finished file is trimmed and closed.
+void SegmentPreparer::run() {
+    while (true) {
+        function<void()> task;
+        {
+            unique_lock<mutex> guard(lock);
+            work.wait(guard, [&] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) {
+                return;
+            }
+            task = move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+// A file system without O_TMPFILE leaves nothing prepared, and open() then creates
+// files itself; one without fallocate still gets the file created ahead of time.
+void SegmentPreparer::create(const string& directory, bool truncate) {
+    int flags = O_TMPFILE | O_WRONLY | O_CLOEXEC | (truncate ? 0 : O_APPEND);
+    int fd = ::open(directory.c_str(), flags, 0644);
+    if (fd < 0) {
+        lock_guard<mutex> guard(lock);
+        if (!warned) {
+            cerr << "Cannot prepare files in " << directory << " (" << strerror(errno) << "), creating them on rotation" << endl;
+            warned = true;
+        }
+        return;
+    }
+    if (bytes > 0) {
+        fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(bytes));
+    }
+
+    lock_guard<mutex> guard(lock);
+    if (readyFd >= 0) {
+        ::close(readyFd);
+    }
+    readyFd = fd;
+    readyDirectory = directory;
+    readyTruncate = truncate;
+}
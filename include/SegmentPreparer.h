@@ -0,0 +1,71 @@
+#ifndef SEGMENT_PREPARER_H
+#define SEGMENT_PREPARER_H
+
+#include <string>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <cstdint>
+
+using namespace std;
+
+// SegmentPreparer takes the file system work of a rotation off the writing thread.
+// A background thread keeps the next file ready as an unnamed file (O_TMPFILE) in
+// the output directory, with its blocks already allocated by fallocate(2). Starting a
+// file takes no system call at all: the writer adopts the descriptor and writes to it
+// at once, while the background thread gives the file its name. Finished files are
+// handed back to the same thread, which trims the unused allocation and closes them.
+class SegmentPreparer {
+public:
+    // Constructor: Starts the background thread; each file is preallocated to `bytes`.
+    explicit SegmentPreparer(uint64_t bytes);
+
+    // Destructor: Finishes queued work, discards an unused prepared file and stops the thread.
+    ~SegmentPreparer();
+
+    SegmentPreparer(const SegmentPreparer&) = delete;
+    SegmentPreparer& operator=(const SegmentPreparer&) = delete;
+
+    // Queues preparing a file in `directory`, opened for appending unless `truncate`.
+    void prepare(const string& directory, bool truncate);
+
+    // Returns the descriptor of the prepared file and queues linking it as `filename`,
+    // or returns -1 if no file is ready for that directory and mode. `filename` should
+    // not exist: if it does by the time the link runs, a truncating file replaces it and
+    // an appending one is named "<filename>.new" instead.
+    int take(const string& filename, bool truncate);
+
+    // Queues trimming the file to its written length and closing the descriptor.
+    void retire(int fd);
+
+    // Directory part of `filename`, "." if it has none.
+    static string directoryOf(const string& filename);
+
+private:
+    uint64_t bytes;                   // Preallocated size of each file
+    int readyFd;                      // Prepared unnamed file, -1 if none
+    string readyDirectory;            // Directory the prepared file lives in
+    bool readyTruncate;               // Open mode of the prepared file
+    bool warned;                      // An unsupported file system was reported
+    thread worker;                    // Background thread
+    deque<function<void()>> tasks;    // Queued work, oldest first
+    bool stopping;                    // Set by the destructor
+    mutex lock;                       // Guards every member above but worker
+    condition_variable work;          // Signaled when a task is queued
+
+    // Queues a task for the background thread.
+    void submit(function<void()> task);
+
+    // Background thread body.
+    void run();
+
+    // Creates and preallocates a file; runs on the background thread.
+    void create(const string& directory, bool truncate);
+
+    // Gives the unnamed file `fd` its name; runs on the background thread.
+    void link(int fd, const string& filename, bool truncate);
+};
+
+#endif // SEGMENT_PREPARER_H
@@ -0,0 +1,203 @@
+#include "SimulatedCapture.h"
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <cmath>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+SimulatedCapture::SimulatedCapture()
+    : signal(Signal::Sine), frequency(1000.0), sampleRate(0), channels(1), pacing(Pacing::Realtime),
+      position(0), opened(false), timerFd(-1), periodFrames(0) {}
+
+SimulatedCapture::~SimulatedCapture() {
+    if (timerFd >= 0) {
+        close(timerFd);
+    }
+}
+
+bool SimulatedCapture::isSimulated(const string& device) {
+    return device.compare(0, 4, "sim:") == 0;
+}
+
+bool SimulatedCapture::parsePacing(const string& text, Pacing& pacing) {
+    if (text == "realtime") {
+        pacing = Pacing::Realtime;
+    } else if (text == "fast") {
+        pacing = Pacing::Fast;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Splits "sim:<signal>[:<argument>]"; the WAV path may itself contain ':'.
+bool SimulatedCapture::open(const string& device, unsigned int sampleRate, unsigned int channels, Pacing pacing) {
+    opened = false;
+    this->sampleRate = sampleRate;
+    this->channels = channels > 0 ? channels : 1;
+    this->pacing = pacing;
+    if (!isSimulated(device) || sampleRate == 0) {
+        return false;
+    }
+
+    string spec = device.substr(4);
+    size_t colon = spec.find(':');
+    string kind = spec.substr(0, colon);
+    string argument = colon == string::npos ? "" : spec.substr(colon + 1);
+
+    if (kind == "sine") {
+        signal = Signal::Sine;
+        frequency = argument.empty() ? 1000.0 : stod(argument);
+    } else if (kind == "noise") {
+        signal = Signal::Noise;
+    } else if (kind == "wav") {
+        signal = Signal::Wav;
+        if (!loadWav(argument)) {
+            return false;
+        }
+    } else {
+        cerr << "Unknown simulated device: " << device << endl;
+        return false;
+    }
+    opened = true;
+    return true;
+}
+
+void SimulatedCapture::start() {
+    position = 0;
+    startTime = chrono::steady_clock::now();
+
+    // Tick once per period like a sound card interrupt; "fast" ticks as often as it is polled
+    if (timerFd >= 0) {
+        long periodNs = pacing == Pacing::Fast ? 1000 : static_cast<long>(1e9 * periodFrames / sampleRate);
+        struct itimerspec timer = {};
+        timer.it_interval.tv_sec = periodNs / 1000000000;
+        timer.it_interval.tv_nsec = periodNs % 1000000000;
+        timer.it_value = timer.it_interval;
+        timerfd_settime(timerFd, 0, &timer, nullptr);
+    }
+}
+
+// The timer is armed by start(); with the default period it fires 100 times per second.
+int SimulatedCapture::enablePolling(size_t periodFrames) {
+    this->periodFrames = periodFrames > 0 ? periodFrames : max<size_t>(sampleRate / 100, 1);
+    if (timerFd < 0) {
+        timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (timerFd < 0) {
+            cerr << "Failed to create timerfd: " << strerror(errno) << endl;
+        }
+    }
+    return timerFd;
+}
+
+// Clears the timer and hands out whatever the pacing clock says is due, never sleeping.
+long SimulatedCapture::readAvailable(int16_t* out, size_t frames) {
+    if (!opened) {
+        return -1;
+    }
+    uint64_t expirations;
+    if (timerFd >= 0 && ::read(timerFd, &expirations, sizeof(expirations)) < 0 && errno != EAGAIN) {
+        cerr << "Failed to read timerfd: " << strerror(errno) << endl;
+    }
+    if (pacing == Pacing::Realtime) {
+        double elapsed = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+        uint64_t due = static_cast<uint64_t>(elapsed * sampleRate);
+        frames = due > position ? min<uint64_t>(frames, due - position) : 0;
+    }
+    generate(out, frames);
+    return static_cast<long>(frames);
+}
+
+// Walks the RIFF chunks to "fmt " and "data"; only 16-bit PCM is accepted.
+bool SimulatedCapture::loadWav(const string& path) {
+    ifstream file(path, ios::binary);
+    char riff[12];
+    if (!file.read(riff, sizeof(riff)) || memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0) {
+        cerr << "Not a WAV file: " << path << endl;
+        return false;
+    }
+
+    uint16_t channels = 0;
+    uint16_t bitsPerSample = 0;
+    uint16_t formatTag = 0;
+    char chunk[8];
+    while (file.read(chunk, sizeof(chunk))) {
+        uint32_t size;
+        memcpy(&size, chunk + 4, sizeof(size));
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            vector<char> fmt(size);
+            if (size < 16 || !file.read(fmt.data(), size)) {
+                cerr << "Not a WAV file: " << path << endl;
+                return false;
+            }
+            memcpy(&formatTag, fmt.data(), sizeof(formatTag));
+            memcpy(&channels, fmt.data() + 2, sizeof(channels));
+            memcpy(&bitsPerSample, fmt.data() + 14, sizeof(bitsPerSample));
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (formatTag != 1 || bitsPerSample != 16 || channels == 0) {
+                cerr << "Only 16-bit PCM WAV files can be replayed: " << path << endl;
+                return false;
+            }
+            vector<int16_t> interleaved(size / sizeof(int16_t));
+            file.read(reinterpret_cast<char*>(interleaved.data()), interleaved.size() * sizeof(int16_t));
+            interleaved.resize(file.gcount() / sizeof(int16_t));
+            wavSamples.clear();
+            for (size_t i = 0; i < interleaved.size(); i += channels) {
+                wavSamples.push_back(interleaved[i]);
+            }
+            if (wavSamples.empty()) {
+                cerr << "WAV file has no samples: " << path << endl;
+                return false;
+            }
+            return true;
+        } else {
+            file.seekg(size + (size & 1), ios::cur); // Chunks are padded to even sizes
+        }
+    }
+    cerr << "WAV file has no data chunk: " << path << endl;
+    return false;
+}
+
+// Sample n depends only on n, so output is identical however reads are split.
+long SimulatedCapture::read(int16_t* out, size_t frames) {
+    if (!opened) {
+        return -1;
+    }
+    if (pacing == Pacing::Realtime) {
+        this_thread::sleep_until(startTime + chrono::duration_cast<chrono::steady_clock::duration>(
+            chrono::duration<double>(static_cast<double>(position + frames) / sampleRate)));
+    }
+    generate(out, frames);
+    return static_cast<long>(frames);
+}
+
+void SimulatedCapture::generate(int16_t* out, size_t frames) {
+    const double pi = 3.14159265358979323846;
+    for (size_t i = 0; i < frames; ++i) {
+        uint64_t n = position + i;
+        int16_t value = 0;
+        switch (signal) {
+            case Signal::Sine:
+                value = static_cast<int16_t>(lrint(16384.0 * sin(2.0 * pi * fmod(frequency * n, sampleRate) / sampleRate)));
+                break;
+            case Signal::Noise: {
+                // splitmix64 of the sample index
+                uint64_t x = n + 0x9E3779B97F4A7C15ull;
+                x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+                x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+                x ^= x >> 31;
+                value = static_cast<int16_t>(static_cast<int32_t>(x >> 48) - 32768) / 2;
+                break;
+            }
+            case Signal::Wav:
+                value = wavSamples[n % wavSamples.size()];
+                break;
+        }
+        fill(out + i * channels, out + (i + 1) * channels, value);
+    }
+    position += frames;
+}
@@ -0,0 +1,84 @@
+#ifndef SIMULATED_CAPTURE_H
+#define SIMULATED_CAPTURE_H
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// SimulatedCapture stands in for an ALSA capture device so audio runs on machines
+// without a sound card. It is selected with `device=sim:...` in AudioDAQ_N.ini:
+//   sim:sine[:<Hz>]     Sine at half full scale, 1000 Hz by default
+//   sim:noise           Deterministic white noise at half full scale
+//   sim:wav:<path>      Replays the first channel of a 16-bit PCM WAV file in a loop
+// Every channel of a multi-channel source carries the same signal.
+// With pacing "realtime" read() returns samples at the configured rate like a
+// sound card; with "fast" it returns immediately to stress the writers.
+// For AudioCaptureEngine the source can also be polled: a timerfd ticks once per
+// period and readAvailable() returns the samples due so far without blocking.
+class SimulatedCapture {
+public:
+    // How quickly read() returns samples.
+    enum class Pacing {
+        Realtime,  // One second of samples per second
+        Fast       // As fast as the consumer reads
+    };
+
+    // Constructor: Creates an unopened source.
+    SimulatedCapture();
+
+    // Destructor: Closes the poll timer.
+    ~SimulatedCapture();
+
+    SimulatedCapture(const SimulatedCapture&) = delete;
+    SimulatedCapture& operator=(const SimulatedCapture&) = delete;
+
+    // True if `device` names a simulated source, i.e. starts with "sim:".
+    static bool isSimulated(const string& device);
+
+    // Parses the device string and loads the WAV file if needed; false on error.
+    bool open(const string& device, unsigned int sampleRate, unsigned int channels, Pacing pacing);
+
+    // Restarts the pacing clock; call right before the first read().
+    void start();
+
+    // Fills `frames` interleaved S16 frames and returns how many were produced, or -1 if not open.
+    long read(int16_t* out, size_t frames);
+
+    // Creates the timerfd that becomes readable every `periodFrames` frames (0 for 10 ms) once
+    // start() runs; returns the descriptor, or -1 on failure.
+    int enablePolling(size_t periodFrames);
+
+    // Non-blocking read(): fills at most `frames` frames that are due now and returns how many.
+    long readAvailable(int16_t* out, size_t frames);
+
+    // Parses "realtime" or "fast"; returns false for anything else.
+    static bool parsePacing(const string& text, Pacing& pacing);
+
+private:
+    // Kind of signal produced.
+    enum class Signal { Sine, Noise, Wav };
+
+    Signal signal;                          // Selected signal
+    double frequency;                       // Sine frequency in Hz
+    unsigned int sampleRate;                // Samples per second
+    unsigned int channels;                  // Samples per frame
+    Pacing pacing;                          // Real-time or as fast as possible
+    vector<int16_t> wavSamples;             // Replayed samples (Wav)
+    uint64_t position;                      // Samples produced since start()
+    chrono::steady_clock::time_point startTime; // Pacing reference
+    bool opened;                            // open() succeeded
+    int timerFd;                            // Period timer for polling, -1 until enablePolling()
+    size_t periodFrames;                    // Frames between timer ticks
+
+    // Writes the next `frames` frames of the signal and advances `position`.
+    void generate(int16_t* out, size_t frames);
+
+    // Loads the first channel of a 16-bit PCM WAV file into wavSamples.
+    bool loadWav(const string& path);
+};
+
+#endif // SIMULATED_CAPTURE_H
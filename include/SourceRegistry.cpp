@@ -0,0 +1,67 @@
+#include "SourceRegistry.h"
+#include "NiDAQ.h"
+#include "AudioDAQ.h"
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+
+namespace fs = filesystem;
+
+SourceRegistry::SourceRegistry() : audioThreads(1), audioEngine(1) {
+    registerType("NiDAQ", [] { return unique_ptr<AcquisitionSource>(new NiDAQHandler()); });
+    registerType("AudioDAQ", [this] {
+        AudioDAQ* audio = new AudioDAQ();
+        if (audioThreads > 0) {
+            audio->setCaptureEngine(&audioEngine);
+        }
+        return unique_ptr<AcquisitionSource>(audio);
+    });
+}
+
+void SourceRegistry::registerType(const string& prefix, Factory factory) {
+    factories[prefix] = move(factory);
+}
+
+void SourceRegistry::setAudioThreads(size_t threads) {
+    audioThreads = threads;
+    audioEngine.setThreads(threads);
+}
+
+// Scans the directory for device INI files and configures a source for each one.
+bool SourceRegistry::load(const string& configDir, size_t ringBlocks) {
+    vector<fs::path> files;
+    error_code ec;
+    for (const auto& entry : fs::directory_iterator(configDir, ec)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".ini") {
+            files.push_back(entry.path());
+        }
+    }
+    if (ec) {
+        cerr << "Cannot read configuration directory: " << configDir << endl;
+        return false;
+    }
+    sort(files.begin(), files.end());
+
+    for (const fs::path& file : files) {
+        string stem = file.stem().string();
+        for (const auto& factory : factories) {
+            if (stem.compare(0, factory.first.size(), factory.first) != 0) {
+                continue;
+            }
+            unique_ptr<AcquisitionSource> source = factory.second();
+            source->setRingBlocks(ringBlocks);
+            cout << "Configuring " << stem << " from " << file.string() << endl;
+            if (!source->configure(file.string().c_str())) {
+                cerr << stem << " initialization failed." << endl;
+                return false;
+            }
+            entries.push_back({ stem, file.string(), move(source) });
+            break;
+        }
+    }
+    return true;
+}
+
+vector<SourceRegistry::Entry>& SourceRegistry::getEntries() {
+    return entries;
+}
@@ -0,0 +1,51 @@
+#ifndef SOURCE_REGISTRY_H
+#define SOURCE_REGISTRY_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+#include "AcquisitionSource.h"
+#include "AudioCaptureEngine.h"
+
+using namespace std;
+
+// SourceRegistry builds acquisition sources from the device INI files in a
+// configuration directory. The source type is chosen by the filename prefix,
+// e.g. "NiDAQ.ini" -> NiDAQHandler, "AudioDAQ_3.ini" -> AudioDAQ.
+class SourceRegistry {
+public:
+    typedef function<unique_ptr<AcquisitionSource>()> Factory;
+
+    // One configured device.
+    struct Entry {
+        string name;                        // INI file stem, also the output directory name
+        string configPath;                  // INI file the source was configured from
+        unique_ptr<AcquisitionSource> source;
+    };
+
+    // Constructor: Registers the built-in NiDAQ and AudioDAQ types.
+    SourceRegistry();
+
+    // Adds a source type for INI files whose name starts with `prefix`.
+    void registerType(const string& prefix, Factory factory);
+
+    // Sets how many threads capture all AudioDAQ devices; 0 gives every device its own thread.
+    // Call before load().
+    void setAudioThreads(size_t threads);
+
+    // Creates and configures one source per matching INI file, in filename order.
+    // Returns false if any device fails to initialize.
+    bool load(const string& configDir, size_t ringBlocks);
+
+    vector<Entry>& getEntries();
+
+private:
+    map<string, Factory> factories; // Filename prefix -> factory
+    size_t audioThreads;            // Threads of audioEngine, 0 if unused
+    AudioCaptureEngine audioEngine; // Shared capture threads; outlives the sources in `entries`
+    vector<Entry> entries;          // Configured sources
+};
+
+#endif // SOURCE_REGISTRY_H
@@ -0,0 +1,48 @@
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+#include <cstdint>
+#include <ctime>
+
+// Acquisition timestamps are nanoseconds on CLOCK_MONOTONIC_RAW: unaffected by NTP
+// slewing and shared by every source, so blocks from different devices line up.
+// realtimeOffsetNs() converts them to wall-clock time for file headers.
+
+// Current CLOCK_MONOTONIC_RAW time in nanoseconds.
+inline int64_t monotonicRawNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// CLOCK_REALTIME minus CLOCK_MONOTONIC_RAW, sampled now; add it to a block timestamp
+// to get nanoseconds since the UNIX epoch.
+inline int64_t realtimeOffsetNs() {
+    struct timespec before, wall, after;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &before);
+    clock_gettime(CLOCK_REALTIME, &wall);
+    clock_gettime(CLOCK_MONOTONIC_RAW, &after);
+    int64_t raw = (static_cast<int64_t>(before.tv_sec) * 1000000000 + before.tv_nsec +
+                   static_cast<int64_t>(after.tv_sec) * 1000000000 + after.tv_nsec) / 2;
+    return static_cast<int64_t>(wall.tv_sec) * 1000000000 + wall.tv_nsec - raw;
+}
+
+// Duration of `frames` frames at `sampleRate` in nanoseconds, exact for any run length.
+inline int64_t framesToNs(uint64_t frames, unsigned int sampleRate) {
+    if (sampleRate == 0) {
+        return 0;
+    }
+    return static_cast<int64_t>((frames / sampleRate) * 1000000000ull +
+                                (frames % sampleRate) * 1000000000ull / sampleRate);
+}
+
+// Whole frames at `sampleRate` in `ns` nanoseconds; the inverse of framesToNs().
+inline uint64_t nsToFrames(int64_t ns, unsigned int sampleRate) {
+    if (ns <= 0) {
+        return 0;
+    }
+    uint64_t whole = static_cast<uint64_t>(ns);
+    return (whole / 1000000000ull) * sampleRate + (whole % 1000000000ull) * sampleRate / 1000000000ull;
+}
+
+#endif // TIMESTAMP_H
@@ -0,0 +1,206 @@
+#include "WavWriter.h"
+#include <iostream>
+#include <cmath>
+#include <cstring>
+
+// Header layout: RIFF(12) + JUNK/ds64(36) + fmt(8 + 16, or 8 + 40 for WAVE_FORMAT_EXTENSIBLE)
+// + data chunk header(8); the data size is the header's last field.
+static const uint32_t DS64_OFFSET = 12;
+static const uint32_t FMT_OFFSET = 48;
+static const uint32_t PCM_FMT_SIZE = 16;
+static const uint32_t EXTENSIBLE_FMT_SIZE = 40;
+static const uint32_t MAX_HEADER_SIZE = FMT_OFFSET + 8 + EXTENSIBLE_FMT_SIZE + 8;
+
+static const uint16_t WAVE_FORMAT_PCM = 1;
+static const uint16_t WAVE_FORMAT_IEEE_FLOAT = 3;
+static const uint16_t WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+// Tail of the KSDATAFORMAT_SUBTYPE_PCM / _IEEE_FLOAT GUIDs, after the format tag.
+static const uint8_t SUBFORMAT_GUID_TAIL[14] = {
+    0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71
+};
+
+static void putU16(char* p, uint16_t v) { memcpy(p, &v, sizeof(v)); }
+static void putU32(char* p, uint32_t v) { memcpy(p, &v, sizeof(v)); }
+static void putU64(char* p, uint64_t v) { memcpy(p, &v, sizeof(v)); }
+
+// Constructor: Generates the first WAV filename.
+// Every encoding but S16_LE needs WAVE_FORMAT_EXTENSIBLE; S24_LE is stored packed.
+WavWriter::WavWriter(int numChannels, unsigned int sampleRate, const string& outputDir, const string& label,
+                     AudioFormat::Encoding encoding, size_t bufferSize)
+    : numChannels(numChannels), sampleRate(sampleRate),
+      bitsPerSample(encoding == AudioFormat::Encoding::S16 ? 16 :
+                    (encoding == AudioFormat::Encoding::S24 || encoding == AudioFormat::Encoding::S24Packed) ? 24 : 32),
+      floating(encoding == AudioFormat::Encoding::Float), outputDir(outputDir), label(label),
+      dataBytes(0), fileBuffer(bufferSize) {
+    headerSize = FMT_OFFSET + 8 + (bitsPerSample == 16 ? PCM_FMT_SIZE : EXTENSIBLE_FMT_SIZE) + 8;
+    currentFilename = generateFilename(outputDir, label, ".wav");
+}
+
+bool WavWriter::checkSource(const AcquisitionSource& source, const string& name, AudioFormat::Encoding& encoding) {
+    if (!source.getAudioEncoding(encoding)) {
+        cerr << "WAV output needs a sound card; " << name << " does not capture PCM audio, use csv or binary." << endl;
+        return false;
+    }
+    return true;
+}
+
+WavWriter::~WavWriter() {
+    lock_guard<mutex> lock(fileMutex);
+    finishFile();
+}
+
+// Writes a header for an empty file; sizes are filled in by finishFile().
+bool WavWriter::openFile(int64_t startNs) {
+    if (!fileBuffer.open(currentFilename, true)) {
+        return false;
+    }
+    index.open(currentFilename, startNs);
+
+    const bool extensible = bitsPerSample != 16;
+    const uint16_t formatTag = floating ? WAVE_FORMAT_IEEE_FLOAT : WAVE_FORMAT_PCM;
+    const uint32_t frameBytes = static_cast<uint32_t>(numChannels * bytesPerSample());
+    char header[MAX_HEADER_SIZE] = {};
+    char* fmt = header + FMT_OFFSET;
+    memcpy(header, "RIFF", 4);
+    memcpy(header + 8, "WAVE", 4);
+    memcpy(header + DS64_OFFSET, "JUNK", 4); // Becomes "ds64" if the file exceeds 4 GB
+    putU32(header + DS64_OFFSET + 4, 28);
+    memcpy(fmt, "fmt ", 4);
+    putU32(fmt + 4, extensible ? EXTENSIBLE_FMT_SIZE : PCM_FMT_SIZE);
+    putU16(fmt + 8, extensible ? WAVE_FORMAT_EXTENSIBLE : formatTag);
+    putU16(fmt + 10, static_cast<uint16_t>(numChannels));
+    putU32(fmt + 12, sampleRate);
+    putU32(fmt + 16, sampleRate * frameBytes);
+    putU16(fmt + 20, static_cast<uint16_t>(frameBytes));
+    putU16(fmt + 22, bitsPerSample);
+    if (extensible) {
+        putU16(fmt + 24, 22);                        // cbSize
+        putU16(fmt + 26, bitsPerSample);             // Valid bits per sample
+        putU32(fmt + 28, 0);                         // Channel mask: no speaker assignment
+        putU16(fmt + 32, formatTag);                 // SubFormat GUID
+        memcpy(fmt + 34, SUBFORMAT_GUID_TAIL, sizeof(SUBFORMAT_GUID_TAIL));
+    }
+    memcpy(header + headerSize - 8, "data", 4);
+
+    fileBuffer.sputn(header, headerSize);
+    dataBytes = 0;
+    return true;
+}
+
+// Patches the chunk sizes; files over 4 GB are switched to RF64 with a ds64 chunk.
+void WavWriter::finishFile() {
+    if (!fileBuffer.isOpen()) {
+        return;
+    }
+
+    uint64_t riffSize = headerSize - 8 + dataBytes;
+    if (riffSize <= UINT32_MAX) {
+        char size[4];
+        putU32(size, static_cast<uint32_t>(riffSize));
+        fileBuffer.writeAt(4, size, sizeof(size));
+        putU32(size, static_cast<uint32_t>(dataBytes));
+        fileBuffer.writeAt(headerSize - 4, size, sizeof(size));
+    } else {
+        char riff[8];
+        memcpy(riff, "RF64", 4);
+        putU32(riff + 4, UINT32_MAX);
+        fileBuffer.writeAt(0, riff, sizeof(riff));
+
+        char ds64[36] = {};
+        memcpy(ds64, "ds64", 4);
+        putU32(ds64 + 4, 28);
+        putU64(ds64 + 8, riffSize);
+        putU64(ds64 + 16, dataBytes);
+        putU64(ds64 + 24, dataBytes / (numChannels * bytesPerSample())); // Sample frames
+        fileBuffer.writeAt(DS64_OFFSET, ds64, sizeof(ds64));
+
+        char size[4];
+        putU32(size, UINT32_MAX);
+        fileBuffer.writeAt(headerSize - 4, size, sizeof(size));
+    }
+    fileBuffer.close();
+    index.close();
+}
+
+// Writes PCM straight from the block; no text conversion is involved.
+// Integer blocks and Float64 blocks of integer encodings hold codes at the source's
+// full scale, and Float64 blocks of FLOAT_LE hold values in [-1, 1], so no scaling is needed.
+void WavWriter::addDataBlock(DataBlock&& block) {
+    lock_guard<mutex> lock(fileMutex); // Ensure thread safety
+    if (!fileBuffer.isOpen() && !openFile(block.timestampNs)) {
+        return;
+    }
+    index.add(dataBytes / (numChannels * bytesPerSample()), block.sequence, block.timestampNs);
+
+    const char* bytes = nullptr; // Converted blocks are written from pcm
+    size_t count = 0;
+    if (block.format == SampleFormat::Int16) {
+        count = block.codes.size();
+        if (bitsPerSample == 16 && !floating) {
+            bytes = reinterpret_cast<const char*>(block.codes.data());
+        } else {
+            convert(block.codes.data(), count);
+        }
+    } else if (block.format == SampleFormat::Int32) {
+        count = block.wideCodes.size();
+        if (bitsPerSample == 32 && !floating) {
+            bytes = reinterpret_cast<const char*>(block.wideCodes.data());
+        } else {
+            convert(block.wideCodes.data(), count);
+        }
+    } else {
+        count = block.values.size();
+        convert(block.values.data(), count);
+    }
+    if (bytes == nullptr) {
+        bytes = reinterpret_cast<const char*>(pcm.data());
+    }
+
+    fileBuffer.sputn(bytes, count * bytesPerSample());
+    dataBytes += count * bytesPerSample();
+}
+
+size_t WavWriter::bytesPerSample() const {
+    return bitsPerSample / 8;
+}
+
+// Integers are rounded and clamped to bitsPerSample; a double holds every int32 exactly.
+template <typename In>
+void WavWriter::convert(const In* samples, size_t count) {
+    const size_t width = bytesPerSample();
+    pcm.resize(count * width);
+    uint8_t* out = pcm.data();
+    if (floating) {
+        for (size_t i = 0; i < count; ++i) {
+            float value = static_cast<float>(samples[i]);
+            memcpy(out + i * sizeof(float), &value, sizeof(float));
+        }
+        return;
+    }
+    const double high = ldexp(1.0, bitsPerSample - 1) - 1;
+    for (size_t i = 0; i < count; ++i) {
+        double v = nearbyint(static_cast<double>(samples[i]));
+        uint32_t code = static_cast<uint32_t>(static_cast<int32_t>(v > high ? high : (v < -high - 1 ? -high - 1 : v)));
+        for (size_t b = 0; b < width; ++b) {
+            out[i * width + b] = static_cast<uint8_t>(code >> (8 * b));
+        }
+    }
+}
+
+// Finishes the current file; the next block opens the new one.
+void WavWriter::updateFilename() {
+    lock_guard<mutex> lock(fileMutex); // Ensure thread safety
+    finishFile();
+    currentFilename = generateFilename(outputDir, label, ".wav");
+}
+
+void WavWriter::setFileFrames(uint64_t frames) {
+    lock_guard<mutex> lock(fileMutex);
+    fileBuffer.setPreallocation(frames > 0 ? headerSize + frames * numChannels * bytesPerSample() : 0);
+}
+
+void WavWriter::setIoMode(BufferedFile::IoMode mode) {
+    lock_guard<mutex> lock(fileMutex);
+    fileBuffer.setIoMode(mode);
+}
@@ -0,0 +1,81 @@
+#ifndef WAV_WRITER_H
+#define WAV_WRITER_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+#include "BufferedFile.h"
+#include "DataWriter.h"
+#include "BlockIndex.h"
+#include "AudioFormat.h"
+#include "AcquisitionSource.h"
+
+using namespace std;
+
+// WavWriter streams blocks into WAV files in the sample format of the sound card:
+// 16-bit PCM for S16_LE, and WAVE_FORMAT_EXTENSIBLE 24-bit PCM (S24_LE, S24_3LE),
+// 32-bit PCM (S32_LE) or 32-bit IEEE float (FLOAT_LE) otherwise. The header reserves
+// a JUNK chunk so a file that grows beyond 4 GB can be turned into RF64 (EBU
+// Tech 3306) in place; the sizes are patched when the file is rotated or closed.
+// Block acquisition times go into a "<file>.wav.idx" sidecar (see BlockIndex).
+class WavWriter : public DataWriter {
+public:
+    // Constructor: Initializes the writer with channel count, sample rate, output directory and label;
+    // `encoding` is that of the source and selects the sample format of the files.
+    WavWriter(int numChannels, unsigned int sampleRate, const string& outputDir, const string& label,
+              AudioFormat::Encoding encoding = AudioFormat::Encoding::S16,
+              size_t bufferSize = BufferedFile::DEFAULT_BUFFER_SIZE);
+
+    // Destructor: Patches the header of the last file and closes it.
+    ~WavWriter() override;
+
+    // Appends interleaved samples. Blocks already in the file's format are written as-is; others are
+    // rounded and clamped to integer PCM, or converted to float for FLOAT_LE files.
+    void addDataBlock(DataBlock&& block) override;
+    using DataWriter::addDataBlock;
+
+    // Finishes the current file and starts a new one when `SaveUnit` is reached.
+    void updateFilename() override;
+
+    // Sets `encoding` to that of `source`. Reports and returns false for sources that do not
+    // capture PCM audio: their raw codes or engineering values would be clamped to PCM.
+    static bool checkSource(const AcquisitionSource& source, const string& name, AudioFormat::Encoding& encoding);
+
+    // Preallocates each new file for `frames` samples per channel; see DataWriter.
+    void setFileFrames(uint64_t frames) override;
+
+    // Sets the I/O mode of the data files; see DataWriter. The header is patched through
+    // the page cache once the samples are written.
+    void setIoMode(BufferedFile::IoMode mode) override;
+
+private:
+    int numChannels;          // Interleaved channels per frame
+    unsigned int sampleRate;  // Sampling rate in Hz
+    uint16_t bitsPerSample;   // 16, 24 or 32
+    bool floating;            // Samples are IEEE float instead of PCM
+    uint32_t headerSize;      // Bytes before the samples
+    string outputDir;         // Directory where WAV files will be stored
+    string label;             // Label to include in the filename
+    string currentFilename;   // Current WAV filename
+    uint64_t dataBytes;       // PCM bytes written to the current file
+    BufferedFile fileBuffer;  // Persistent file handle and write buffer
+    BlockIndex index;         // Acquisition time of every block in the current file
+    vector<uint8_t> pcm;      // Conversion buffer for blocks not in the file's format
+    mutex fileMutex;          // Mutex for thread safety
+
+    // Creates the file and its index and writes a provisional header; `startNs` is the first block's time.
+    bool openFile(int64_t startNs);
+
+    // Writes the final RIFF or RF64 sizes and closes the file.
+    void finishFile();
+
+    // Bytes of one sample of one channel in the file.
+    size_t bytesPerSample() const;
+
+    // Converts `count` samples into pcm in the file's format.
+    template <typename In>
+    void convert(const In* samples, size_t count);
+};
+
+#endif // WAV_WRITER_H
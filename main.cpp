@@ -1,12 +1,18 @@
 // main.cpp
-#include "./include/NiDAQ.h"         // Include the header file for NiDAQ handler
-#include "./include/AudioDAQ.h"      // Include the header file for AudioDAQ handler
+#include "./include/SourceRegistry.h" // Include the registry that builds NiDAQ and AudioDAQ sources
+#include "./include/Pipeline.h"       // Include the pipeline that moves blocks from sources to writers
 #include "./include/CSVWriter.h"     // Include the header file for CSVWriter utility
+#include "./include/BinaryWriter.h"  // Include the header file for the binary recording format
+#include "./include/WavWriter.h"     // Include the header file for WAV/RF64 audio output
+#include "./include/AsyncWriter.h"   // Include the header file for the background writer thread
+#include "./include/ParallelEncoder.h" // Include the header file for multi-core block compression
+#include "./include/RotatingWriter.h"  // Include the header file for sample-accurate file rotation
 #include <iostream>
 #include <chrono>                    // Include chrono library for timestamp generation
 #include <vector>
 #include <string>
 #include <atomic>
+#include <memory>
 #include <termios.h>                 // Include for terminal input settings
 #include <unistd.h>                  // Include for POSIX API (UNIX system calls)
 #include <fcntl.h>                   // Include for file control options (e.g., non-blocking mode)
@@ -72,6 +78,31 @@ string getCurrentTime() {
     return string(buffer);
 }
 
+/**
+ * @brief Parse a comma-separated list of integers such as "6,6,4".
+ * 
+ * Entries that are not numbers are skipped.
+ * 
+ * @return The parsed values in order.
+ */
+vector<int> parseIntList(const string& text) {
+    vector<int> values;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t end = text.find(',', start);
+        if (end == string::npos) {
+            end = text.size();
+        }
+        try {
+            values.push_back(stoi(text.substr(start, end - start)));
+        } catch (const exception&) {
+            // Ignore empty or malformed entries
+        }
+        start = end + 1;
+    }
+    return values;
+}
+
 int main( void ) {
     atexit(resetTerminalMode); // Ensure terminal mode is restored when the program exits
     
@@ -93,30 +124,76 @@ int main( void ) {
         int SaveUnit = reader.GetInteger(targetSection, targetKey, 60);
         cout << "[" << targetSection << "] " << targetKey << " = " << SaveUnit << endl;
 
-        // Initialize DAQ devices
-        NiDAQHandler niDaq;
-        AudioDAQ audioDaq_1;
-        AudioDAQ audioDaq_2;
-
-        // Configuration file paths for each device
-        const char* NiDAQconfigPath = "API/NiDAQ.ini";
-        const char* audioDaq_1configPath = "API/AudioDAQ_1.ini";
-        const char* audioDaq_2configPath = "API/AudioDAQ_2.ini";
-
-        // Hardware initialization
-        TaskInfo info = niDaq.prepareTask(NiDAQconfigPath);
-        audioDaq_1.initDevices(audioDaq_1configPath);
-        audioDaq_2.initDevices(audioDaq_2configPath);
-
-        // Check if DAQ initialization was successful
-        if (info.sampleRate <= 0 || info.numChannels <= 0) {
-            cerr << "NiDAQ Initialization failed." << endl;
-            return 1;
+        // Read the CSV file handling mode and write buffer size
+        bool persistentCSV = reader.Get("CSVWriter", "mode", "persistent") != "reopen";
+        size_t csvBufferSize = static_cast<size_t>(reader.GetInteger("CSVWriter", "bufferKB", 1024)) * 1024;
+        CSVWriter::Mode csvMode = persistentCSV ? CSVWriter::Mode::Persistent : CSVWriter::Mode::Reopen;
+        cout << "[CSVWriter] mode = " << (persistentCSV ? "persistent" : "reopen") << endl;
+
+        // Read the CSV precision: one value for all channels or a comma-separated list per channel
+        vector<int> csvPrecision = parseIntList(reader.Get("CSVWriter", "precision", "-1"));
+
+        // Read the output format ("csv", "binary" or "wav") and the binary sample type;
+        // an [Output <device>] section overrides either one for one device
+        string outputFormat = reader.Get("Output", "format", "csv");
+        string sampleTypeName = reader.Get("Output", "sampleType", "float32");
+        BinaryWriter::SampleType binarySampleType = BinaryWriter::SampleType::Float32;
+        if (!BinaryWriter::parseSampleType(sampleTypeName, binarySampleType)) {
+            cerr << "Unknown sample type: " << sampleTypeName << ", using float32." << endl;
+        }
+        // Lossless compression of binary files with an integer sample type ("none" or "rice")
+        string compressionName = reader.Get("Output", "compression", "none");
+        BinaryWriter::Compression binaryCompression = BinaryWriter::Compression::None;
+        if (!BinaryWriter::parseCompression(compressionName, binaryCompression)) {
+            cerr << "Unknown compression: " << compressionName << ", using none." << endl;
+        }
+        // Write data files through the page cache ("buffered") or around it ("direct", O_DIRECT),
+        // which keeps long high-rate recordings from building up dirty pages
+        string ioName = reader.Get("Output", "io", "buffered");
+        BufferedFile::IoMode ioMode = BufferedFile::IoMode::Buffered;
+        if (!BufferedFile::parseIoMode(ioName, ioMode)) {
+            cerr << "Unknown io mode: " << ioName << ", using buffered." << endl;
+        }
+        cout << "[Output] format = " << outputFormat << endl;
+
+        // Read the writer queue length and what to do when it is full
+        size_t queueBlocks = static_cast<size_t>(reader.GetInteger("Writer", "queueBlocks", 8));
+        string policyName = reader.Get("Writer", "policy", "block");
+        AsyncWriter::Policy queuePolicy = AsyncWriter::Policy::Block;
+        if (!AsyncWriter::parsePolicy(policyName, queuePolicy)) {
+            cerr << "Unknown writer policy: " << policyName << ", using block." << endl;
         }
-        if (audioDaq_1.getSampleRate() <= 0 || audioDaq_2.getSampleRate() <= 0) {
-            cerr << "AudioDAQ Initialization failed." << endl;
+        cout << "[Writer] queueBlocks = " << queueBlocks << ", policy = " << policyName << endl;
+
+        // Compressed streams are encoded on a shared pool of compressionThreads threads
+        // (0 compresses on each writer thread) holding at most compressionBudgetMB of blocks
+        size_t compressionThreads = static_cast<size_t>(reader.GetInteger("Writer", "compressionThreads", 0));
+        size_t compressionBudget = static_cast<size_t>(reader.GetInteger("Writer", "compressionBudgetMB", 64)) * 1024 * 1024;
+        unique_ptr<CompressionPool> compressionPool;
+        if (compressionThreads > 0) {
+            compressionPool = make_unique<CompressionPool>(compressionThreads, compressionBudget);
+        }
+        cout << "[Writer] compressionThreads = " << compressionThreads << endl;
+        // Create and preallocate each stream's next file in the background so rotation does not stall
+        bool preallocate = reader.GetBoolean("Writer", "preallocate", true);
+        cout << "[Writer] preallocate = " << (preallocate ? "true" : "false") << endl;
+
+        // Build one acquisition source per device INI file in API/
+        SourceRegistry registry;
+        size_t ringBlocks = static_cast<size_t>(reader.GetInteger("Acquisition", "ringBlocks", 8));
+        // All sound cards share audioThreads polling threads; 0 gives each card its own thread
+        registry.setAudioThreads(static_cast<size_t>(reader.GetInteger("Acquisition", "audioThreads", 1)));
+        if (!registry.load("API", ringBlocks) || registry.getEntries().empty()) {
+            cerr << "DAQ initialization failed." << endl;
             return 1;
         }
+        // "annotate" stamps blocks from each device's fitted sample clock so the
+        // timestamps of different devices stay comparable over long runs
+        string alignMode = reader.Get("Acquisition", "align", "none");
+        for (SourceRegistry::Entry& entry : registry.getEntries()) {
+            entry.source->setAlignTimestamps(alignMode == "annotate");
+        }
+        cout << "[Acquisition] align = " << alignMode << endl;
         cout << "Initialization completed." << endl;
 
         // Prompt user for label input
@@ -127,30 +204,73 @@ int main( void ) {
         cin >> label;
         string folder = getCurrentTime() + "_" + label;
 
-        // Create output directories for data storage
-        fs::create_directory("output/NiDAQ/" + folder);
-        fs::create_directory("output/AudioDAQ_1/" + folder);
-        fs::create_directory("output/AudioDAQ_2/" + folder);
-
-        // Initialize CSVWriter objects for saving data
-        CSVWriter NiDAQcsv(info.numChannels, "output/NiDAQ/" + folder, label);
-        CSVWriter audioDaq_1csv(1, "output/AudioDAQ_1/" + folder, label);
-        CSVWriter audioDaq_2csv(1, "output/AudioDAQ_2/" + folder, label);
+        // Create a writer in the configured output format, running on its own thread
+        auto createWriter = [&](const string& format, BinaryWriter::SampleType sampleType, BinaryWriter::Compression compression, BufferedFile::IoMode io, AudioFormat::Encoding encoding, const vector<ChannelInfo>& channels, double sampleRate, const string& outputDir) {
+            unique_ptr<DataWriter> fileWriter;
+            if (format == "binary") {
+                auto binary = make_unique<BinaryWriter>(channels, sampleRate, outputDir, label, sampleType);
+                binary->setCompression(compression);
+                fileWriter = move(binary);
+            } else if (format == "wav") {
+                fileWriter = make_unique<WavWriter>(static_cast<int>(channels.size()), static_cast<unsigned int>(sampleRate), outputDir, label, encoding);
+            } else {
+                auto csv = make_unique<CSVWriter>(static_cast<int>(channels.size()), outputDir, label, csvMode, csvBufferSize);
+                csv->setPrecision(csvPrecision);
+                csv->setScaling(channels); // Raw ADC codes are written in engineering units
+                fileWriter = move(csv);
+            }
+            // Every file holds exactly SaveUnit seconds of samples, whatever the block length
+            uint64_t framesPerFile = static_cast<uint64_t>(SaveUnit > 0 ? SaveUnit : 1) * static_cast<uint64_t>(sampleRate);
+            fileWriter->setFileFrames(preallocate ? framesPerFile : 0);
+            fileWriter->setIoMode(io);
+            if (compressionPool && fileWriter->encodesInParallel()) {
+                fileWriter = make_unique<ParallelEncoder>(move(fileWriter), *compressionPool);
+            }
+            fileWriter = make_unique<RotatingWriter>(move(fileWriter), framesPerFile, channels.size(), static_cast<unsigned int>(sampleRate));
+            return make_unique<AsyncWriter>(move(fileWriter), queueBlocks, queuePolicy, outputDir + "/" + label + ".spill");
+        };
+
+        // Connect every source to a writer in output/<device>/<folder>
+        Pipeline pipeline;
+        for (SourceRegistry::Entry& entry : registry.getEntries()) {
+            string outputDir = "output/" + entry.name + "/" + folder;
+            fs::create_directories(outputDir);
+            string format = reader.Get("Output " + entry.name, "format", outputFormat);
+            cout << entry.name << " output format = " << format << endl;
+            string typeName = reader.Get("Output " + entry.name, "sampleType", sampleTypeName);
+            BinaryWriter::SampleType sampleType = binarySampleType;
+            if (!BinaryWriter::parseSampleType(typeName, sampleType)) {
+                cerr << "Unknown sample type: " << typeName << ", using " << sampleTypeName << "." << endl;
+            }
+            string compressionOverride = reader.Get("Output " + entry.name, "compression", compressionName);
+            BinaryWriter::Compression compression = binaryCompression;
+            if (!BinaryWriter::parseCompression(compressionOverride, compression)) {
+                cerr << "Unknown compression: " << compressionOverride << ", using " << compressionName << "." << endl;
+            }
+            string ioOverride = reader.Get("Output " + entry.name, "io", ioName);
+            BufferedFile::IoMode io = ioMode;
+            if (!BufferedFile::parseIoMode(ioOverride, io)) {
+                cerr << "Unknown io mode: " << ioOverride << ", using " << ioName << "." << endl;
+            }
+            cout << entry.name << " io = " << ioOverride << endl;
+            // WAV files take the sound card's sample format and are refused for other sources
+            AudioFormat::Encoding encoding = AudioFormat::Encoding::S16;
+            if (format == "wav" && !WavWriter::checkSource(*entry.source, entry.name, encoding)) {
+                return 1;
+            }
+            auto writer = createWriter(format, sampleType, compression, io, encoding, entry.source->getChannels(), entry.source->getSampleRate(), outputDir);
+            if (!pipeline.addStream(entry.name, entry.source.get(), move(writer))) {
+                return 1;
+            }
+        }
 
         // Start DAQ tasks
-        if (niDaq.startTask() != 0) {
-            cerr << "Failed to start NiDAQ task." << endl;
-            return 1;
+        for (SourceRegistry::Entry& entry : registry.getEntries()) {
+            if (!entry.source->start()) {
+                cerr << "Failed to start " << entry.name << "." << endl;
+                return 1;
+            }
         }
-        audioDaq_1.startCapture();
-        audioDaq_2.startCapture();
-
-        // NomalTimer = times for saving data
-        // tmpTimer = times for package data
-        // proTimer = times for program data
-        int NiDAQTimer = 0, NiDAQtmpTimer = 0, NiDAQproTimer = 0;
-        int audioDaq_1Timer = 0, audioDaq_1tmpTimer = 0, audioDaq_1proTimer = 0;
-        int audioDaq_2Timer = 0, audioDaq_2tmpTimer = 0, audioDaq_2proTimer = 0;
 
         system("clear"); // Clear terminal screen for better readability
         cout << "==================== Data Acquisition Program ==================" << endl;
@@ -159,10 +279,19 @@ int main( void ) {
         cout << "Start reading data, press 'Q' or 'q' to terminate the program." << endl;
 
         setNonBlockingMode(); // Enable non-blocking input mode
+        pipeline.watchInput(STDIN_FILENO);
 
+        // Sleep until the user types or a device signals a finished block
         while (isRunning) {
-            // Check for user input (non-blocking)
-            if (read(STDIN_FILENO, &ch, 1) > 0) {
+            if (!pipeline.waitAndService(-1)) {
+                continue;
+            }
+
+            // Check for user input
+            ssize_t n = read(STDIN_FILENO, &ch, 1);
+            if (n == 0) {
+                pipeline.unwatchInput(); // stdin closed; stop waiting on it
+            } else if (n > 0) {
                 if (ch == 'Q' || ch == 'q') {
                     isRunning = false;
                     cout << "Saving final data before exit..." << endl;
@@ -171,76 +300,13 @@ int main( void ) {
                 }
                 cout << "You pressed: " << ch << endl;
             }
-
-            // Process NiDAQ data
-            int NiDAQtmpTimes = niDaq.getReadTimes();
-            if (NiDAQtmpTimes > NiDAQtmpTimer) {
-                double* dataBuffer = niDaq.getDataBuffer();
-                vector<double> dataBlock(dataBuffer, dataBuffer + info.sampleRate * info.numChannels);
-                NiDAQcsv.addDataBlock(move(dataBlock));
-                NiDAQtmpTimer = NiDAQtmpTimes;
-
-                NiDAQTimer++;
-                NiDAQproTimer++;
-                cout << "=========================================" << endl;
-                cout << "NiDAQ Saving Timer:  " << NiDAQTimer << endl;
-                cout << "NiDAQ Program Timer: " << NiDAQproTimer << endl;
-                cout << "NiDAQ Package Timer: " << NiDAQtmpTimer << endl;
-                
-                if (NiDAQTimer == SaveUnit) {
-                    NiDAQcsv.updateFilename();
-                    NiDAQTimer = 0;
-                    cout << "NiDAQ CSV Saved" << endl;
-                }
-            }
-
-            // Process AudioDAQ_1 data
-            int audioDaq_1tmpTimes = audioDaq_1.getTimes();
-            if (audioDaq_1tmpTimes > audioDaq_1tmpTimer) {
-                auto buffer = audioDaq_1.getBuffer();
-                audioDaq_1csv.addDataBlock(move(buffer));
-                audioDaq_1tmpTimer = audioDaq_1tmpTimes;
-
-                audioDaq_1Timer++;
-                audioDaq_1proTimer++;
-                cout << "Audio 1 Saving Timer:  " << audioDaq_1Timer << endl;
-                cout << "Audio 1 Program Timer: " << audioDaq_1proTimer << endl;
-                cout << "Audio 1 Package Timer: " << audioDaq_1tmpTimer << endl;
-
-                if (audioDaq_1Timer == SaveUnit) {
-                    audioDaq_1csv.updateFilename();
-                    audioDaq_1Timer = 0;
-                    cout << "AudioDAQ_1 CSV Saved" << endl;
-                }
-            }
-
-            // Process AudioDAQ_2 data
-            int audioDaq_2tmpTimes = audioDaq_2.getTimes();
-            if (audioDaq_2tmpTimes > audioDaq_2tmpTimer) {
-                auto buffer = audioDaq_2.getBuffer();
-                audioDaq_2csv.addDataBlock(move(buffer));
-                audioDaq_2tmpTimer = audioDaq_2tmpTimes;
-
-                audioDaq_2Timer++;
-                audioDaq_2proTimer++;
-                cout << "Audio 2 Saving Timer:  " << audioDaq_2Timer << endl;
-                cout << "Audio 2 Program Timer: " << audioDaq_2proTimer << endl;
-                cout << "Audio 2 Package Timer: " << audioDaq_2tmpTimer << endl;
-
-                if (audioDaq_2Timer == SaveUnit) {
-                    audioDaq_2csv.updateFilename();
-                    audioDaq_2Timer = 0;
-                    cout << "AudioDAQ_1 CSV Saved" << endl;
-                }
-            }
         }
 
         resetTerminalMode(); // Restore terminal settings
 
         cout << "Stopping DAQ and saving remaining data..." << endl;
-        niDaq.stopAndClearTask();
-        audioDaq_1.stopCapture();
-        audioDaq_2.stopCapture();
+        pipeline.stopAll();
+        pipeline.serviceAll();
     }
 
     return 0;